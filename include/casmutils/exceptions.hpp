@@ -49,6 +49,24 @@ public:
 
 private:
 };
+class BadPOSCAR : public std::runtime_error
+{
+public:
+    BadPOSCAR(const std::string& reason) : std::runtime_error("Could not read POSCAR: " + reason) {}
+};
+
+class BadArchive : public std::runtime_error
+{
+public:
+    BadArchive(const std::string& reason) : std::runtime_error("Invalid structure archive: " + reason) {}
+};
+
+class BadPreparedMapper : public std::runtime_error
+{
+public:
+    BadPreparedMapper(const std::string& reason) : std::runtime_error("Invalid prepared mapper: " + reason) {}
+};
+
 class OverwriteException : public std::runtime_error
 {
 public:
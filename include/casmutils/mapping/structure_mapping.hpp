@@ -3,21 +3,38 @@
 #include <casm/crystallography/BasicStructureTools.hh>
 #include <casm/crystallography/SimpleStrucMapCalculator.hh>
 #include <casm/crystallography/StrucMapping.hh>
+#include <casmutils/definitions.hpp>
 #include <casmutils/exceptions.hpp>
+#include <casmutils/misc.hpp>
 #include <casmutils/sym/cartesian.hpp>
+#include <casmutils/xtal/fingerprint.hpp>
 #include <casmutils/xtal/lattice.hpp>
 #include <casmutils/xtal/structure.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
 
 namespace casmutils
 {
 namespace mapping
 {
+struct CompactMappingReport;
+
+/// Why CASM flagged the node as invalid, or an empty string if it's valid
+std::string invalid_map_reason(const CASM::xtal::MappingNode& casm_mapping_node);
+
 /// Holds the results of a structure map
 /// Fundamentally this includes some strain representation,
 /// displacement representation, site assignment matrix/permutation vector,
 /// reference superlattice, rigid rotation, and rigid translation.
 /// These quantities can be transformed and then converted to a mapping score
-/// using strain_cost and basis_cost
+/// using strain_cost and basis_cost.
+/// Invalid nodes (only kept with MappingInput::keep_invalid_mapping_nodes) still make a report,
+/// with valid set to false and the reason filled in, so they never throw.
 struct MappingReport
 {
     MappingReport(const CASM::xtal::MappingNode& casm_mapping_node)
@@ -25,20 +42,20 @@ struct MappingReport
           stretch(casm_mapping_node.stretch()),
           translation(casm_mapping_node.translation()),
           displacement(casm_mapping_node.atom_displacement),
+          permutation(casm_mapping_node.atom_permutation.begin(), casm_mapping_node.atom_permutation.end()),
           reference_lattice(casm_mapping_node.lattice_node.parent.superlattice()),
           mapped_lattice(casm_mapping_node.lattice_node.child.superlattice()),
           lattice_cost(casm_mapping_node.lattice_node.cost),
           basis_cost(casm_mapping_node.atomic_node.cost),
-          cost(casm_mapping_node.cost)
+          cost(casm_mapping_node.cost),
+          valid(casm_mapping_node.is_valid),
+          reason(invalid_map_reason(casm_mapping_node))
     {
-        std::vector<int> p(casm_mapping_node.atom_permutation.begin(), casm_mapping_node.atom_permutation.end());
-        permutation = p;
-        if (!casm_mapping_node.is_valid)
-        {
-            throw except::InvalidMap();
-        }
     }
 
+    /// Expands a compact report back into a full one
+    explicit MappingReport(const CompactMappingReport& compact_report);
+
     Eigen::Matrix3d isometry;
     Eigen::Matrix3d stretch;
     Eigen::Vector3d translation;
@@ -51,11 +68,57 @@ struct MappingReport
     double basis_cost;
     double cost;
 
+    /// False if CASM flagged the map as invalid, in which case reason says why
+    bool valid;
+    std::string reason;
+
     // This is potentially a superlattice of the originally passed in reference structure
     xtal::Lattice reference_lattice;
     xtal::Lattice mapped_lattice;
 };
 
+/// Same results as a MappingReport, for when many reports have to be kept around at once.
+/// The lattices are stored as their column vector matrices instead of full xtal::Lattice objects
+/// (which carry caches of their own), and the displacement only stores its columns as dynamic.
+/// Expand into a MappingReport when the full interface is needed.
+/// Measured with GCC on x86-64, the report itself takes 416 bytes instead of 584, about 71% of a
+/// MappingReport. The displacement and permutation take the same 3N doubles and N ints on the heap
+/// in both, so the saving is a fixed 168 bytes per report, whatever the size of the structure.
+struct CompactMappingReport
+{
+    CompactMappingReport(const CASM::xtal::MappingNode& casm_mapping_node);
+    explicit CompactMappingReport(const MappingReport& report);
+
+    Eigen::Matrix3d isometry;
+    Eigen::Matrix3d stretch;
+    Eigen::Vector3d translation;
+
+    Eigen::Matrix3Xd displacement;
+    std::vector<std::int32_t> permutation;
+
+    double lattice_cost;
+    double basis_cost;
+    double cost;
+
+    /// False if CASM flagged the map as invalid, in which case reason says why
+    bool valid;
+    std::string reason;
+
+    /// Column vector matrices of the reference superlattice and the mapped lattice
+    Eigen::Matrix3d reference_lattice;
+    Eigen::Matrix3d mapped_lattice;
+};
+
+/// Outcome of mapping a single structure out of many. Holds either the reports, or the reason
+/// the structure couldn't be mapped at all.
+struct MappingResult
+{
+    std::vector<MappingReport> reports;
+    std::string error;
+
+    bool ok() const { return this->error.empty(); }
+};
+
 /// Holds the parameters that are required to conduct a structure map, including
 /// the lattice vs. basis weighting, the maximum allowed volume change from
 /// the reference structure, options to the algorithm (sym_basis,sym_strain,robust,strict), tolerance
@@ -85,7 +148,9 @@ public:
           assume_ideal_lattice(false),
           assume_ideal_structure(false),
           /* assume_deformed_structure(false), */
-          use_crystal_symmetry(false)
+          use_crystal_symmetry(false),
+          cache_size(0),
+          collect_stats(false)
     {
     }
 
@@ -103,9 +168,13 @@ public:
     double max_cost;
     double min_cost;
 
+    /// Set to true to only map onto the lattice of the reference itself, in any of its orientations,
+    /// instead of searching through its supercells.
     bool impose_reference_lattice;
     /// Set to true if the mapped structure has a lattice that is a direct integer tranformation
-    /// of the reference, but the basis is relaxed.
+    /// of the reference, in any orientation, but the basis is relaxed. Only the basis is mapped then.
+    /// Mapping a structure whose lattice isn't such a supercell of the reference (within tol) throws
+    /// UserInputMangle. Takes precedence over impose_reference_lattice.
     bool assume_ideal_lattice;
     /// Set to true if you know that the mapped structure is a direct integer transformation of the reference.
     /// Implies ideal lattice.
@@ -120,15 +189,60 @@ public:
     /// when performing the mapping
     bool use_crystal_symmetry;
 
+    /// Number of mapped structures whose reports the mapper remembers, so that mapping the same
+    /// structure again costs a lookup instead of a full map. Only an identical structure (same
+    /// lattice, coordinates and species, bit for bit) is answered from the cache, so cached reports
+    /// are exactly what mapping would return. The least recently mapped structures are forgotten
+    /// first. Set to 0 to disable the cache.
+    int cache_size;
+
+    /// When true, the mapper keeps track of where the time of its maps goes (see MappingStats)
+    bool collect_stats;
+
 private:
     // TODO: This might eventually collapse into ATOM mode only, so it's disabled for now
     /* SpecMode mode; */
 };
 
+class MappingEnumerator;
+
+/// Where the time of a mapper's calls went, and how much work they did. Only collected if the mapper
+/// was made with MappingInput::collect_stats, otherwise no clock is ever read.
+/// The search for nodes happens inside CASM, so the lattice enumeration and the assignment problems
+/// can only be timed together, as search_seconds.
+struct MappingStats
+{
+    /// Structures that were mapped, or checked with is_equivalent
+    std::size_t structures = 0;
+    /// Maps that were answered by the report cache without searching
+    std::size_t cache_hits = 0;
+    /// Mapping nodes that the searches came back with
+    std::size_t nodes_found = 0;
+    /// Checks with is_equivalent that were settled by the composition, fingerprint or lattice, without searching
+    std::size_t ruled_out_early = 0;
+    /// Bytes held by the reports that were made, including their displacements and permutations
+    std::size_t report_bytes = 0;
+
+    /// Finding the factor group of the reference
+    double symmetry_seconds = 0;
+    /// Making cache keys, and looking them up in or adding them to the report cache
+    double cache_seconds = 0;
+    /// Searching for mapping nodes, i.e. enumerating lattices and solving the assignment problems
+    double search_seconds = 0;
+    /// Turning mapping nodes into reports
+    double report_seconds = 0;
+
+    MappingStats& operator+=(const MappingStats& other);
+};
+
 /// Can map a structure to its internal reference can be used for mapping many
 /// different test structures to the same reference.
 /// Default values for the point group is the factor group of the reference structure,
 /// and the allowed species are whatever is residing at the reference structure.
+/// A single mapper can be called from many threads at once. The reference is prepared once and
+/// shared, while each call borrows a private copy of the CASM mapper (whose caches aren't thread safe)
+/// from a pool, so concurrent calls never touch the same mutable state.
+/// Copies of a mapper share that pool.
 // TODO: Explain each constructor argument in detail
 class StructureMapper_f
 {
@@ -150,18 +264,143 @@ public:
 
     std::vector<MappingReport> operator()(const xtal::Structure& mappable_struc) const;
 
+    /// Same maps as operator(), returned as compact reports for when many of them have to be kept.
+    /// The reports are made straight from the mapping results and never go through the cache.
+    std::vector<CompactMappingReport> map_compact(const xtal::Structure& mappable_struc) const;
+
+    /// How often a map was answered by the cache (see MappingInput::cache_size)
+    std::size_t cache_hits() const { return this->report_cache ? this->report_cache->hits() : 0; }
+
+    /// How often a map had to be computed even though the cache is enabled
+    std::size_t cache_misses() const { return this->report_cache ? this->report_cache->misses() : 0; }
+
+    /// Number of structures whose reports are currently in the cache
+    std::size_t cache_size() const { return this->report_cache ? this->report_cache->size() : 0; }
+
+    /// Walks through the maps of the structure in order of increasing cost, only computing as many as
+    /// are asked for, instead of a fixed number of k_best_maps. The mapper must outlive the enumerator.
+    /// CASM can't resume a search, so whenever the maps found so far run out, the enumerator searches
+    /// again from scratch for twice as many. Handing out N maps therefore takes about log2(N) full
+    /// searches, which repeat the lattice enumeration and find about 2N nodes between them. If the
+    /// number of maps is known up front, a single call with that many k_best_maps is cheaper.
+    MappingEnumerator enumerate(const xtal::Structure& mappable_struc) const;
+
+    /// Returns true if the structure maps onto the reference with a cost of at most min_cost (or tol,
+    /// if min_cost isn't positive). Structures that can't be equivalent are rejected on their composition
+    /// and fingerprint before any mapping. Otherwise the search stops at the first map that's cheap enough,
+    /// and no MappingReport is ever made. The search honors the same settings as operator(), except that
+    /// with assume_ideal_lattice, a lattice that isn't a supercell of the reference returns false instead
+    /// of throwing. Only the shape matters, not the volume, since the cost doesn't change when everything is scaled.
+    bool is_equivalent(const xtal::Structure& mappable_struc) const;
+
+    /// Same as is_equivalent, but reuses a fingerprint made by make_equivalence_fingerprint with the same
+    /// MappingInput, for when one structure gets checked against many mappers.
+    bool is_equivalent(const xtal::Structure& mappable_struc,
+                       const xtal::StructureFingerprint& mappable_fingerprint) const;
+
+    /// Writes everything the mapper was prepared from to a JSON file: the reference structure, the
+    /// settings, the factor group and the allowed species. See load.
+    void save(const fs::path& prepared_path) const;
+
+    /// Makes a mapper from a file written by save. The factor group and allowed species are read
+    /// instead of worked out again, which is most of the setup for large, low symmetry references.
+    /// Throws BadPreparedMapper if the file isn't a prepared mapper. The cache size and collect_stats
+    /// aren't saved, so the loaded mapper has neither a report cache nor stats.
+    static StructureMapper_f load(const fs::path& prepared_path);
+
+    /// Totals of every call since the mapper was made or its stats were last reset. Calls from
+    /// map_many and from other threads add up into the same totals. Always empty unless
+    /// MappingInput::collect_stats was set. Copies of the mapper share their stats.
+    MappingStats stats() const;
+
+    /// Starts the totals of stats() over from zero, e.g. to see the stats of a single call
+    void reset_stats();
+
+    /// Maps every structure onto the reference, using n_threads threads (0 means use every core).
+    /// The reference is only prepared once, and the reports come back in the same order as the structures.
+    /// Equivalent to calling operator() on each structure.
+    std::vector<std::vector<MappingReport>> map_many(const std::vector<xtal::Structure>& mappable_strucs,
+                                                     int n_threads = 0) const;
+
+    /// Same as map_many, but a structure that can't be mapped doesn't stop the others, its error is
+    /// kept in its result instead. Nothing is thrown, however many of the structures fail.
+    std::vector<MappingResult> try_map_many(const std::vector<xtal::Structure>& mappable_strucs,
+                                            int n_threads = 0) const;
+
 private:
     xtal::Structure reference_structure;
     xtal::Lattice lattice_to_impose;
     MappingInput settings;
 
+    /// Totals of the stats of every call, guarded by a mutex. Null unless stats are collected.
+    struct StatsCollector
+    {
+        std::mutex mutex;
+        MappingStats totals;
+    };
+    std::shared_ptr<StatsCollector> stats_collector;
+
     std::vector<sym::CartOp> factor_group;
     AllowedSpeciesType allowed_species;
 
+    /// Prepared for the reference, but never mapped with directly. Every map goes through a copy
+    /// borrowed from the pool.
     CASM::xtal::StrucMapper mapper;
 
-    std::vector<mapping::MappingReport> map(const xtal::Structure& mappable_struc) const;
-    std::vector<mapping::MappingReport> ideal_map(const xtal::Structure& mappable_struc) const;
+    /// Copies of the prepared mapper that aren't in use by any call right now
+    struct MapperPool
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<CASM::xtal::StrucMapper>> idle_mappers;
+    };
+    std::shared_ptr<MapperPool> mapper_pool;
+
+    /// Reports of recently mapped structures, keyed by their quantized lattice, species and coordinates.
+    /// Null if the cache is disabled.
+    std::shared_ptr<LRUCache<std::string, std::vector<MappingReport>>> report_cache;
+
+    /// Fingerprint of the reference for quickly ruling out structures in is_equivalent. Only made if
+    /// every reference site allows exactly the species on it, otherwise the composition of a mappable
+    /// structure says nothing about whether it maps.
+    std::optional<xtal::StructureFingerprint> reference_fingerprint;
+
+    /// Returns true if the composition shows that the structure can't be equivalent
+    bool is_obviously_not_equivalent(const xtal::Structure& mappable_struc) const;
+
+    /// Searches for a single map with a cost within the equivalence threshold
+    bool has_equivalent_map(const xtal::Structure& mappable_struc) const;
+
+    /// Key for the report cache. It holds the raw bytes of the lattice, coordinates and species, so
+    /// structures only share a key if they are identical.
+    std::string make_cache_key(const xtal::Structure& mappable_struc) const;
+
+    /// Takes a mapper out of the pool, or copies the prepared one if they're all in use. The mapper
+    /// goes back into the pool once the last copy of the returned pointer is gone.
+    std::shared_ptr<CASM::xtal::StrucMapper> borrow_mapper() const;
+
+    /// Finds the k cheapest nodes (and any that tie with the last one) within the settings' max_cost
+    std::set<CASM::xtal::MappingNode> k_best_nodes(const xtal::Structure& mappable_struc, int k) const;
+
+    friend class MappingEnumerator;
+
+    /// Same as k_best_nodes, but searches with the given mapper, which must be a borrowed copy of this->mapper
+    std::set<CASM::xtal::MappingNode>
+    find_nodes(const CASM::xtal::StrucMapper& casm_mapper, const xtal::Structure& mappable_struc, int k) const;
+
+    /// Same as find_nodes, but with the given costs and invalid node handling instead of the settings' ones
+    std::set<CASM::xtal::MappingNode> find_nodes(const CASM::xtal::StrucMapper& casm_mapper,
+                                                 const xtal::Structure& mappable_struc,
+                                                 int k,
+                                                 double max_cost,
+                                                 double min_cost,
+                                                 bool keep_invalid) const;
+
+    /// Maps with the given mapper, which must be a borrowed copy of this->mapper
+    std::vector<mapping::MappingReport> map_with(const CASM::xtal::StrucMapper& casm_mapper,
+                                                 const xtal::Structure& mappable_struc) const;
+
+    /// Adds the stats of a call to the totals, if stats are being collected
+    void record_stats(const MappingStats& call_stats) const;
 
     /// Returns the factor group of the reference structure
     std::vector<sym::CartOp> make_default_factor_group() const;
@@ -170,13 +409,62 @@ private:
     AllowedSpeciesType make_default_allowed_species() const;
 };
 
+/// Hands out the maps of a structure onto the reference of a StructureMapper_f one at a time, cheapest first,
+/// so that a caller looking for the first map that fits some criteria never pays for the rest.
+/// The CASM search can't be resumed, so maps are found in batches that double in size each time
+/// the previous batch runs out. A MappingReport is only made when it's handed out.
+class MappingEnumerator
+{
+public:
+    /// Returns the next cheapest map, or nothing once every map within max_cost has been handed out
+    std::optional<MappingReport> next();
+
+private:
+    friend class StructureMapper_f;
+    MappingEnumerator(const StructureMapper_f& mapper, const xtal::Structure& mappable_struc);
+
+    const StructureMapper_f* mapper;
+    xtal::Structure mappable_struc;
+
+    /// The cheapest maps found so far, in order of increasing cost
+    std::vector<CASM::xtal::MappingNode> found_nodes;
+    std::size_t next_node_ix;
+
+    /// Whether the last search came up with fewer maps than asked for, meaning there are no more
+    bool is_exhausted;
+};
+
+/// True if the other structure maps onto the reference structure with a cost of at most the min_cost
+/// of the given input (see StructureMapper_f::is_equivalent). This prepares the reference for every
+/// comparison, so make a StructureMapper_f instead when comparing many structures to the same one.
+class StructureEquals_f
+{
+public:
+    StructureEquals_f(const MappingInput& input);
+    bool operator()(const xtal::Structure& reference, const xtal::Structure& other) const;
+
+private:
+    MappingInput settings;
+};
+
+/// Fingerprint of the structure, scaled to a volume per atom of 1, with a tolerance derived from both the
+/// lattice and basis parts of the settings' equivalence threshold, so that structures which map onto each
+/// other within it are never ruled out (see StructureMapper_f::is_equivalent). Throws if the strain weight
+/// is 0 or 1, since any strain or any displacement is then equivalent.
+xtal::StructureFingerprint make_equivalence_fingerprint(const xtal::Structure& struc, const MappingInput& input);
+
 /// Calculates lattice and basis score from ideal lattice, stretch tensor and displacement matrix
 /// Returns scores for lattice (first) and basis (second) as a pair.
 std::pair<double, double> structure_score(const mapping::MappingReport& mapping_data);
 
-/// Map a single structure onto a reference structure with default settings
+/// Map a single structure onto a reference structure with default settings.
+/// If a cache directory is given, the mapper prepared for the reference is saved there (see
+/// StructureMapper_f::save), and loaded instead of prepared again whenever the same reference comes back.
+/// The file is named prepared_mapper_<hash>.json after a fixed (FNV-1a) hash of the reference and settings,
+/// so different builds share the same cache directory.
 std::vector<mapping::MappingReport> map_structure(const xtal::Structure& map_reference_struc,
-                                                  const xtal::Structure& mappable_struc);
+                                                  const xtal::Structure& mappable_struc,
+                                                  const fs::path& cache_dir = "");
 
 /// Calculates the symmetry preserving part of the MappingReport according to the given factor group
 /// This is the part of the distortion that has the same symmetry as the given factor group.
@@ -185,6 +473,15 @@ mapping::MappingReport symmetry_preserving_mapping_report(const mapping::Mapping
                                                           const std::vector<sym::CartOp>& group_as_operations,
                                                           const std::vector<sym::PermRep>& group_as_permutations);
 
+/// Same as calling symmetry_preserving_mapping_report on each report, with the same results to the last bit.
+/// The group is prepared once for all of the reports, which get spread over n_threads threads
+/// (0 means use every core). Every permutation must reorder as many sites as each report has.
+std::vector<mapping::MappingReport>
+symmetry_preserving_mapping_reports(const std::vector<mapping::MappingReport>& all_mapping_data,
+                                    const std::vector<sym::CartOp>& group_as_operations,
+                                    const std::vector<sym::PermRep>& group_as_permutations,
+                                    int n_threads = 0);
+
 } // namespace mapping
 } // namespace casmutils
 #endif
@@ -4,7 +4,12 @@
 #include <casm/external/Eigen/Core>
 #include <casm/misc/CASM_Eigen_math.hh>
 #include <casm/misc/type_traits.hh>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace CASM
@@ -56,6 +61,184 @@ private:
     BinaryComparator_f m_compare_method;
 };
 
+/// Holds a value that is expensive to construct and only built when someone asks for it.
+/// Once built, the value is shared between copies of the cache, and is only ever modified
+/// through modify_if_unique when no other copy can see it. Calling invalidate() marks the
+/// value as dirty, so that the next access builds a fresh one.
+/// Concurrent const access is safe: if several threads race to build the value, only the
+/// first one to finish is kept, and everyone gets a reference to it.
+template <typename ValueType> class LazyCache
+{
+public:
+    /// Returns the cached value, building it with the provided factory if it's dirty.
+    /// The reference stays valid until the cache is invalidated or set (or modified while shared with
+    /// a copy), since those release the value it points to. Copy the value if it has to outlive them.
+    template <typename Factory> const ValueType& get(Factory&& make_value) const
+    {
+        std::shared_ptr<ValueType> current = std::atomic_load(&m_value);
+        if (current == nullptr)
+        {
+            auto fresh = std::make_shared<ValueType>(make_value());
+            if (std::atomic_compare_exchange_strong(&m_value, &current, fresh))
+            {
+                current = std::move(fresh);
+            }
+        }
+        return *current;
+    }
+
+    /// Store a value that is known to be up to date, avoiding a rebuild on the next access
+    void set(ValueType up_to_date_value)
+    {
+        std::atomic_store(&m_value, std::make_shared<ValueType>(std::move(up_to_date_value)));
+    }
+
+    /// Apply an edit to the cached value, so that it stays up to date without a full rebuild.
+    /// This is only possible if the value has been built and isn't shared with any copies,
+    /// otherwise the cache is marked as dirty instead. Returns true if the edit was applied.
+    template <typename Modifier> bool modify_if_unique(Modifier&& modify)
+    {
+        if (m_value != nullptr && m_value.use_count() == 1)
+        {
+            modify(*m_value);
+            return true;
+        }
+        this->invalidate();
+        return false;
+    }
+
+    /// Mark the cached value as dirty
+    void invalidate() { std::atomic_store(&m_value, std::shared_ptr<ValueType>()); }
+
+    /// Returns true if a value has been built and hasn't been invalidated since
+    bool is_current() const { return std::atomic_load(&m_value) != nullptr; }
+
+private:
+    mutable std::shared_ptr<ValueType> m_value;
+};
+
+/// Holds a value that is shared between copies until one of them needs to modify it, at which
+/// point that copy makes its own version of the value first (copy on write). Copying is then
+/// as cheap as copying a pointer, no matter how big the value is.
+template <typename ValueType> class CopyOnWrite
+{
+public:
+    CopyOnWrite() : m_value(std::make_shared<ValueType>()) {}
+    CopyOnWrite(ValueType init_value) : m_value(std::make_shared<ValueType>(std::move(init_value))) {}
+
+    /// Read only access to the value, which may be shared with other copies
+    const ValueType& read() const { return *m_value; }
+
+    /// Access to the value for modification. If the value is shared, a private copy is made first.
+    ValueType& write()
+    {
+        if (m_value.use_count() > 1)
+        {
+            m_value = std::make_shared<ValueType>(*m_value);
+        }
+        return *m_value;
+    }
+
+    /// Replace the value entirely, which never needs to copy the old one
+    void reset(ValueType new_value) { m_value = std::make_shared<ValueType>(std::move(new_value)); }
+
+private:
+    std::shared_ptr<ValueType> m_value;
+};
+
+/// Remembers the values of up to capacity keys, forgetting the least recently used one
+/// when a new key comes in. Keeps count of how many lookups found their key (hits) and
+/// how many didn't (misses). All the member functions are safe to call from many threads at once.
+template <typename KeyType, typename ValueType, typename Hash = std::hash<KeyType>> class LRUCache
+{
+public:
+    LRUCache(std::size_t capacity) : m_capacity(capacity) {}
+
+    /// Returns a copy of the value stored for the key, if there is one, and marks it as the most recently used
+    std::optional<ValueType> get(const KeyType& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto lookup_it = m_lookup.find(key);
+        if (lookup_it == m_lookup.end())
+        {
+            ++m_misses;
+            return std::nullopt;
+        }
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, lookup_it->second);
+        return lookup_it->second->second;
+    }
+
+    /// Store the value for the key, replacing the old one if the key is already stored
+    void put(const KeyType& key, ValueType value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_capacity == 0)
+        {
+            return;
+        }
+
+        auto lookup_it = m_lookup.find(key);
+        if (lookup_it != m_lookup.end())
+        {
+            lookup_it->second->second = std::move(value);
+            m_entries.splice(m_entries.begin(), m_entries, lookup_it->second);
+            return;
+        }
+
+        if (m_entries.size() == m_capacity)
+        {
+            m_lookup.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+        m_entries.emplace_front(key, std::move(value));
+        m_lookup.emplace(key, m_entries.begin());
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    std::size_t capacity() const { return m_capacity; }
+
+    std::size_t hits() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hits;
+    }
+
+    std::size_t misses() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_misses;
+    }
+
+    /// Forget every stored value, and reset the hit and miss counts
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        m_lookup.clear();
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+private:
+    typedef std::list<std::pair<KeyType, ValueType>> EntryList;
+
+    std::size_t m_capacity;
+    mutable std::mutex m_mutex;
+
+    /// Most recently used first
+    EntryList m_entries;
+    std::unordered_map<KeyType, typename EntryList::iterator, Hash> m_lookup;
+
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+};
+
 } // namespace casmutils
 
 /**
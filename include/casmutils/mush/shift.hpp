@@ -75,7 +75,10 @@ std::vector<xtal::Structure> make_shifted_structures(const xtal::Structure& slab
 
 /// Given a list of slab structures with different shifts applied, return a list of indexes
 /// that describe which structures are equivalent to each other. The vector at index i contains
-/// all the indexes of the structures that are equivalent to the structure at index i.
+/// all the indexes of the structures that are equivalent to the structure at index i, in
+/// increasing order. Each structure is only mapped against one member of every group of
+/// equivalent structures, and only if their fingerprints (see xtal::fingerprint) don't already
+/// rule it out.
 std::vector<std::vector<std::size_t>>
 categorize_equivalently_shifted_structures(const std::vector<xtal::Structure>& shifted_structures);
 } // namespace mush
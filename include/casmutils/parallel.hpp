@@ -0,0 +1,137 @@
+#ifndef CASMUTILS_PARALLEL_HH
+#define CASMUTILS_PARALLEL_HH
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace casmutils
+{
+/// Number of threads to actually use for the given amount of work. Asking for 0 (or fewer)
+/// threads means as many as the machine has, and there's never more threads than tasks.
+inline int resolve_thread_count(int n_threads, std::size_t n_tasks)
+{
+    if (n_threads < 1)
+    {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::max<std::size_t>(1, std::min<std::size_t>(n_threads, n_tasks));
+}
+
+/// Calls work(state, ix) for every ix from 0 to n_tasks on a pool of worker threads, where each
+/// worker gets its own state by calling make_state() once before it starts. Use the state for anything
+/// that can't be shared between threads, e.g. objects with internal caches.
+/// Each worker takes the next index as soon as it's done with the last one, so cheap and expensive tasks
+/// even out. If any call throws, the remaining tasks are skipped, and the first exception is rethrown
+/// once every worker is done.
+template <typename MakeState, typename Work>
+void parallel_for_with_state(std::size_t n_tasks, int n_threads, MakeState&& make_state, Work&& work)
+{
+    n_threads = resolve_thread_count(n_threads, n_tasks);
+    if (n_threads == 1)
+    {
+        auto state = make_state();
+        for (std::size_t ix = 0; ix < n_tasks; ++ix)
+        {
+            work(state, ix);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next_task(0);
+    std::exception_ptr first_error;
+    std::mutex error_mutex;
+    auto worker = [&]() {
+        try
+        {
+            auto state = make_state();
+            for (std::size_t ix = next_task++; ix < n_tasks; ix = next_task++)
+            {
+                work(state, ix);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!first_error)
+            {
+                first_error = std::current_exception();
+            }
+            next_task = n_tasks;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(n_threads - 1);
+    try
+    {
+        for (int t = 1; t < n_threads; ++t)
+        {
+            pool.emplace_back(worker);
+        }
+    }
+    catch (...)
+    {
+        // Threads that are still joinable when destroyed call std::terminate, so the ones that
+        // did start are stopped and joined before giving up
+        next_task = n_tasks;
+        for (std::thread& thread : pool)
+        {
+            thread.join();
+        }
+        throw;
+    }
+    // The calling thread does its share of the work too
+    worker();
+    for (std::thread& thread : pool)
+    {
+        thread.join();
+    }
+
+    if (first_error)
+    {
+        std::rethrow_exception(first_error);
+    }
+}
+
+/// Calls work(ix) for every ix from 0 to n_tasks on a pool of worker threads (see parallel_for_with_state).
+/// The work function must be safe to call concurrently for different indices.
+template <typename Work> void parallel_for(std::size_t n_tasks, int n_threads, Work&& work)
+{
+    parallel_for_with_state(
+        n_tasks, n_threads, []() { return nullptr; }, [&work](std::nullptr_t, std::size_t ix) { work(ix); });
+}
+
+/// Calls work(state, ix) for every ix from 0 to n_tasks on a pool of worker threads (see parallel_for_with_state),
+/// and hands each result to emit(ix, result) in order of ix, as soon as every earlier result has been emitted.
+/// Results are emitted while later tasks are still running, and emit is never called by two threads at once,
+/// so it can write straight to a stream. Only the results that are waiting for an earlier one are held.
+template <typename MakeState, typename Work, typename Emit>
+void parallel_for_ordered(std::size_t n_tasks, int n_threads, MakeState&& make_state, Work&& work, Emit&& emit)
+{
+    using StateType = decltype(make_state());
+    using ResultType = decltype(work(std::declval<StateType&>(), std::size_t(0)));
+
+    std::vector<std::optional<ResultType>> waiting_results(n_tasks);
+    std::size_t next_to_emit = 0;
+    std::mutex emit_mutex;
+    parallel_for_with_state(n_tasks, n_threads, make_state, [&](StateType& state, std::size_t ix) {
+        ResultType result = work(state, ix);
+        std::lock_guard<std::mutex> lock(emit_mutex);
+        waiting_results[ix].emplace(std::move(result));
+        for (; next_to_emit < n_tasks && waiting_results[next_to_emit]; ++next_to_emit)
+        {
+            emit(next_to_emit, std::move(*waiting_results[next_to_emit]));
+            waiting_results[next_to_emit].reset();
+        }
+    });
+}
+} // namespace casmutils
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef UTILS_ARCHIVE_HH
+#define UTILS_ARCHIVE_HH
+
+#include <casmutils/definitions.hpp>
+#include <casmutils/xtal/structure.hpp>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace casmutils
+{
+namespace xtal
+{
+/// Numbers describing how an archived structure came to be, such as the shift (ShiftRecord),
+/// cleavage, or Moire size of a structure coming out of an enumeration.
+using ArchiveMetadata = std::map<std::string, double>;
+
+/// Entry in the index of a structure archive. Points to where the basis of the structure is
+/// stored, and to the lattice in the lattice table.
+struct ArchiveRecord
+{
+    std::string key;
+    std::uint64_t offset;
+    std::uint64_t site_count;
+    std::uint64_t lattice_index;
+    ArchiveMetadata metadata;
+};
+
+/**
+ * A structure archive holds many structures in a single file, so that enumerations don't
+ * have to write out a directory tree with a POSCAR for each structure. The file is laid out as:
+ *
+ * - a header to identify the file (and the byte order it was written in)
+ * - the basis of each structure, as a contiguous block of Cartesian coordinates followed by species indices
+ * - a string table of species names, which the species indices refer to
+ * - a table of lattices, which structures with the same lattice share
+ * - the index, with a key, the position of the basis block, a lattice index and metadata for every structure
+ * - a footer that says where the tables begin
+ *
+ * The tables come last so that new structures can be appended to an existing archive. Values are
+ * stored in the byte order of the machine that wrote them.
+ */
+
+/// Appends structures to an archive, which is created if it doesn't exist. Everything is written to
+/// a uniquely named copy next to the archive, which replaces the archive once the tables and index are
+/// written by close(). Until then, and if writing fails at any point, the archive is left exactly as it
+/// was. A writer that is destroyed without being closed throws its copy away, so nothing appended to it
+/// ends up in the archive. Appending to an existing archive copies it first.
+class StructureArchiveWriter
+{
+public:
+    StructureArchiveWriter(const fs::path& archive_path);
+    StructureArchiveWriter(const StructureArchiveWriter&) = delete;
+    StructureArchiveWriter& operator=(const StructureArchiveWriter&) = delete;
+    ~StructureArchiveWriter();
+
+    /// Add a structure to the archive. Throws if the key is already in use, or if the structure
+    /// can't be written, which also abandons everything appended since opening the writer.
+    void append(const std::string& key, const Structure& struc, const ArchiveMetadata& metadata = {});
+
+    /// Number of structures in the archive, including the ones that were there before opening it
+    std::size_t size() const { return this->records.size(); }
+
+    /// Write the tables and index to finish the archive, and put it in place of the old one.
+    /// Nothing can be appended afterwards. This is the only way the archive ever changes.
+    void close();
+
+private:
+    fs::path archive_path;
+    /// Where the archive gets written before it replaces the one at archive_path
+    fs::path staging_path;
+    std::ofstream archive_stream;
+
+    /// Position in the file where the next basis block goes
+    std::uint64_t write_offset;
+
+    std::vector<std::string> species_names;
+    std::unordered_map<int, std::uint64_t> species_index_of_id;
+
+    std::vector<Eigen::Matrix3d> lattices;
+    std::map<std::vector<double>, std::uint64_t> lattice_index_of_values;
+
+    std::vector<ArchiveRecord> records;
+    std::unordered_map<std::string, std::size_t> record_index_of_key;
+
+    /// Returns the index in the lattice table of the given lattice, adding it if it's new
+    std::uint64_t _lattice_index(const Lattice& lat);
+
+    /// Throws if the last write failed, after closing and removing the partial copy
+    void _check_stream();
+};
+
+/// Random access to the structures of an archive. The file is memory mapped, so only the
+/// structures that are asked for are ever read.
+class StructureArchiveReader
+{
+public:
+    StructureArchiveReader(const fs::path& archive_path);
+
+    /// Number of structures in the archive
+    std::size_t size() const { return this->archive_records.size(); }
+
+    /// Every record in the index, in the order the structures were appended
+    const std::vector<ArchiveRecord>& records() const { return this->archive_records; }
+
+    /// Keys of every structure, in the order they were appended
+    std::vector<std::string> keys() const;
+
+    bool contains(const std::string& key) const;
+
+    /// Read the structure with the given key. Throws if there's no such key.
+    Structure structure(const std::string& key) const;
+
+    /// Read the structure at the given position of the index
+    Structure structure(std::size_t index) const;
+
+    /// Metadata that was stored with the structure. Throws if there's no such key.
+    const ArchiveMetadata& metadata(const std::string& key) const;
+
+    /// Write the structure with the given key out as a POSCAR file
+    void export_poscar(const std::string& key, const fs::path& poscar_path) const;
+
+    /// Names of the species that appear in the archive, as they are stored in the species table
+    const std::vector<std::string>& species_names() const { return this->archive_species_names; }
+
+    /// Lattices of the archive, as they are stored in the lattice table
+    const std::vector<Eigen::Matrix3d>& lattices() const { return this->archive_lattices; }
+
+    /// Position of the footer, where the tables begin. New structures get appended from here.
+    std::uint64_t tables_offset() const { return this->archive_tables_offset; }
+
+private:
+    /// The mapped file, which is unmapped once the last copy of the reader is gone
+    std::shared_ptr<const char> mapped_data;
+    std::size_t mapped_size;
+
+    std::uint64_t archive_tables_offset;
+    std::vector<std::string> archive_species_names;
+    std::vector<int> species_ids;
+    std::vector<Eigen::Matrix3d> archive_lattices;
+    std::vector<ArchiveRecord> archive_records;
+    std::unordered_map<std::string, std::size_t> record_index_of_key;
+
+    /// Throws if there's no such key
+    const ArchiveRecord& _record(const std::string& key) const;
+
+    /// Builds the structure out of its basis block in the mapped file
+    Structure _read_structure(const ArchiveRecord& record) const;
+};
+} // namespace xtal
+} // namespace casmutils
+
+#endif
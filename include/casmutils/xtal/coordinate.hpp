@@ -22,6 +22,26 @@ Eigen::Vector3d bring_within_lattice(const Eigen::Vector3d& cartesian_coordinate
 /// Brings the given cartesian coordinates within the wigner seitz cell of the given lattice
 Eigen::Vector3d bring_within_wigner_seitz(const Eigen::Vector3d& cartesian_coordinate, const Lattice& lat);
 
+// The batched versions below operate on many coordinates at once, stored as the columns
+// of a 3xN matrix. They can't share a name with the single coordinate versions, since
+// Eigen allows implicit conversions between matrix types, which would make the calls ambiguous.
+
+/// Returns cartesian coordinates for every column of fractional coordinates given
+Eigen::Matrix3Xd fractional_to_cartesian_batch(const Eigen::Ref<const Eigen::Matrix3Xd>& fractional_coordinates,
+                                               const Lattice& lat);
+
+/// Returns fractional coordinates for every column of cartesian coordinates given
+Eigen::Matrix3Xd cartesian_to_fractional_batch(const Eigen::Ref<const Eigen::Matrix3Xd>& cartesian_coordinates,
+                                               const Lattice& lat);
+
+/// Brings every column of the given cartesian coordinates within the given lattice
+Eigen::Matrix3Xd bring_within_lattice_batch(const Eigen::Ref<const Eigen::Matrix3Xd>& cartesian_coordinates,
+                                            const Lattice& lat);
+
+/// Brings every column of the given cartesian coordinates within the wigner seitz cell of the given lattice
+Eigen::Matrix3Xd bring_within_wigner_seitz_batch(const Eigen::Ref<const Eigen::Matrix3Xd>& cartesian_coordinates,
+                                                 const Lattice& lat);
+
 struct CoordinateEquals_f
 {
     /// for casmutils::xtal::Coordinate
@@ -0,0 +1,57 @@
+#ifndef UTILS_FINGERPRINT_HH
+#define UTILS_FINGERPRINT_HH
+
+#include <array>
+#include <casmutils/xtal/structure.hpp>
+#include <cstdint>
+
+namespace casmutils
+{
+namespace xtal
+{
+/**
+ * A cheap, fixed size summary of a structure that doesn't change under rigid rotations,
+ * translations, reordering of the basis, or a different choice of supercell. Structures
+ * with different fingerprints can't be equivalent, so comparing fingerprints first
+ * discards most pairs before any mapping has to happen.
+ *
+ * The fingerprint holds:
+ * - the composition, reduced to the smallest integer counts, as a hash
+ * - the volume per atom
+ * - a smeared histogram of the distances from every atom to its neighbours, averaged over
+ *   the atoms. Distances are measured in units of the cube root of the volume per atom.
+ */
+struct StructureFingerprint
+{
+    static constexpr int histogram_bins = 48;
+
+    /// Distances in the histogram go from 0 up to this many times the cube root of the volume per atom
+    static constexpr double histogram_range = 3.0;
+
+    std::uint64_t composition_hash;
+    double volume_per_atom;
+    std::array<double, histogram_bins> distance_histogram;
+
+    /// How much each bin of the histogram may differ for structures whose atoms are
+    /// within the tolerance of each other
+    std::array<double, histogram_bins> histogram_tolerance;
+
+    /// Tolerance the fingerprint was made with
+    double tol;
+
+    /// A 64 bit hash that is the same on every platform and every run. Equivalent structures
+    /// share the hash, except in the rare case that their fingerprints sit on either side of
+    /// a rounding boundary, so compare fingerprints with could_be_equivalent when that matters.
+    std::uint64_t hash() const;
+};
+
+/// Summarizes the structure so that it can be compared against others cheaply (see StructureFingerprint)
+StructureFingerprint fingerprint(const Structure& struc, double tol);
+
+/// Returns false if the fingerprints show that their structures can't be equivalent within the tolerance
+/// they were made with. Returning true doesn't mean the structures are equivalent, only that they might be.
+bool could_be_equivalent(const StructureFingerprint& lhs, const StructureFingerprint& rhs);
+} // namespace xtal
+} // namespace casmutils
+
+#endif
@@ -3,11 +3,18 @@
 
 #include <casm/crystallography/Lattice.hh>
 #include <casmutils/definitions.hpp>
+#include <casmutils/misc.hpp>
 
 namespace casmutils
 {
 namespace xtal
 {
+/**
+ * Three lattice vectors, stored as the columns of a 3x3 matrix. Anything derived from the
+ * vectors (inverse, metric, reciprocal, Niggli form, and the CASM implementation) is only
+ * computed the first time it's requested, and then kept around. Copies of a Lattice share
+ * whatever has already been computed.
+ */
 class Lattice
 {
 public:
@@ -45,7 +52,7 @@ public:
 
     // TODO: Read up on Eigen::Matrix3d::ColXpr and decide if you prefer this. CASM does it this way.
     /// Return the ith vector of the lattice
-    Eigen::Vector3d operator[](int i) const { return this->__get()[i]; }
+    Eigen::Vector3d operator[](int i) const { return this->column_lat_mat.col(i); }
 
     /// Return the first vector of the lattice
     Eigen::Vector3d a() const { return this->operator[](0); }
@@ -56,23 +63,41 @@ public:
     /// Return the third vector of the lattice
     Eigen::Vector3d c() const { return this->operator[](2); }
 
-    /// Return the volume of this lattice
-    double volume() const { return this->__get().volume(); }
+    /// Return the volume of this lattice (negative for left handed lattices)
+    double volume() const { return this->column_lat_mat.determinant(); }
 
     /// Returns the matrix representation of this lattice where each lattice vector is a column
-    Eigen::Matrix3d column_vector_matrix() const { return this->__get().lat_column_mat(); }
+    const Eigen::Matrix3d& column_vector_matrix() const { return this->column_lat_mat; }
 
     /// Returns the matrix representation of this lattice where each lattice vector is a row
-    Eigen::Matrix3d row_vector_matrix() const { return this->column_vector_matrix().transpose(); }
+    Eigen::Matrix3d row_vector_matrix() const { return this->column_lat_mat.transpose(); }
+
+    /// Returns the inverse of the column vector matrix, which converts Cartesian coordinates to fractional ones
+    const Eigen::Matrix3d& inverse_column_vector_matrix() const;
+
+    /// Returns the metric tensor of the lattice (dot products between every pair of lattice vectors)
+    const Eigen::Matrix3d& metric() const;
 
     /// Return *this as a CASM::Lattice
-    const CASM::xtal::Lattice& __get() const { return this->casm_lattice; }
+    const CASM::xtal::Lattice& __get() const;
 
 private:
+    friend Lattice make_reciprocal(const Lattice& real_lattice);
+    friend Lattice make_niggli(const Lattice& non_niggli_lattice);
+
     static Eigen::Matrix3d
     stack_column_vectors(const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c);
 
-    CASM::xtal::Lattice casm_lattice;
+    /// The lattice vectors as columns, this is the authoritative state of the lattice
+    Eigen::Matrix3d column_lat_mat;
+
+    LazyCache<Eigen::Matrix3d> inverse_lat_mat;
+    LazyCache<Eigen::Matrix3d> metric_mat;
+    LazyCache<Lattice> reciprocal_lattice;
+    LazyCache<Lattice> niggli_lattice;
+
+    /// CASM::Lattice representation, built on demand
+    LazyCache<CASM::xtal::Lattice> casm_lattice;
 };
 
 // TODO: Make this a binary comparator, fix is_equal, and implement UnaryComparator_f
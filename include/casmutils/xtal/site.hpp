@@ -12,8 +12,9 @@ namespace xtal
 class Lattice;
 
 /**
- * A coordinate and type of species. Even though it's implemented
- * with CASM::xtal::Site, it can *NOT* describe mutiple possible occupants.
+ * A Cartesian coordinate and type of species. It can *NOT* describe mutiple possible occupants.
+ * The species is stored as an id into the global species table (see species.hpp),
+ * which keeps Site small and free of heap allocations.
  */
 
 class Site
@@ -22,20 +23,23 @@ public:
     Site() = delete;
     Site(const CASM::xtal::Site& init_site, int occupant);
     Site(const Eigen::Vector3d& init_coord, const std::string& occupant_name);
+    Site(const Eigen::Vector3d& init_coord, int occupant_species_id);
 
     /// Retreive the Cartesian values of the coordinate
-    Eigen::Vector3d cart() const;
+    const Eigen::Vector3d& cart() const { return this->cart_coord; }
     /// Retreive the fractional values of the coordinate relative to the provided lattice
     Eigen::Vector3d frac(const Lattice& ref_lattice) const;
 
     /// Name of the species residing on the site
-    std::string label() const;
+    const std::string& label() const;
 
-    /// Access  the CASM implementation within.
-    /* const CASM::xtal::Site& __get() const {return casm_site;}; */
+    /// Id of the species residing on the site (see species.hpp). Comparing
+    /// ids is equivalent to comparing labels, but doesn't touch any strings.
+    int species() const { return this->occupant_id; }
 
 private:
-    CASM::xtal::Site casm_site;
+    Eigen::Vector3d cart_coord;
+    int occupant_id;
 };
 
 /// This functor class provides a unary equals operator
@@ -0,0 +1,32 @@
+#ifndef UTILS_SPECIES_HH
+#define UTILS_SPECIES_HH
+
+#include <string>
+
+namespace casmutils
+{
+namespace xtal
+{
+/**
+ * Species names are interned in a process-wide table, so that sites can
+ * refer to their occupant with a small integer instead of carrying a string around.
+ * Ids are handed out in the order names are first seen, and are stable for
+ * the lifetime of the process. Safe to call from multiple threads.
+ */
+
+/// Returns the id of the given species name, registering it if it hasn't been seen before
+int species_id(const std::string& species_name);
+
+/// Returns the name that was registered for the given species id. Doesn't take a lock, so it's cheap
+/// enough for hot loops. Throws std::out_of_range if no name was registered for the id.
+const std::string& species_name(int species_id);
+
+/// Returns the number of species names that have been registered so far
+int species_count();
+
+/// Returns true if the name stands for an empty site, as CASM spells it ("Va", "VA" or "va")
+bool is_vacancy(const std::string& species_name);
+} // namespace xtal
+} // namespace casmutils
+
+#endif
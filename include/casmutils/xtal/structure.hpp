@@ -4,9 +4,12 @@
 #include <casm/crystallography/BasicStructure.hh>
 #include <casm/crystallography/SimpleStructure.hh>
 #include <casmutils/definitions.hpp>
+#include <casmutils/misc.hpp>
 #include <casmutils/xtal/lattice.hpp>
 #include <casmutils/xtal/site.hpp>
 #include <iostream>
+#include <string_view>
+#include <vector>
 namespace casmutils
 {
 namespace xtal
@@ -19,6 +22,9 @@ using CASM::FRAC;
  * Describes a current, fixed state of a crystal. Composed of a lattice,
  * and collection of basis atoms (Sites). Each site contains the position of
  * the species, and a label for the species.
+ * The basis is stored as a contiguous block of Cartesian coordinates (one column per site)
+ * along with the interned species id of each site, so that bulk operations on the
+ * basis are a single matrix operation.
  */
 
 class Structure
@@ -30,6 +36,13 @@ public:
     /// Construct by providing a path to a POSCAR like file
     static Structure from_poscar(const fs::path& poscar_path);
 
+    /// Construct by reading a POSCAR from the stream. The whole stream is read in at once.
+    static Structure from_poscar_stream(std::istream& poscar_stream);
+
+    /// Construct from the text of a POSCAR. Handles VASP 4 and 5 formats, Selective Dynamics,
+    /// and Direct or Cartesian coordinates. Throws except::BadPOSCAR if the text can't be read.
+    static Structure from_poscar_string(std::string_view poscar_text);
+
     /// Construct from parent CASM class
     Structure(const CASM::xtal::SimpleStructure& init_struc);
     Structure(const CASM::xtal::BasicStructure& init_struc);
@@ -37,6 +50,13 @@ public:
     /// Construct with a lattice and list of sites (basis)
     Structure(const Lattice& init_lat, const std::vector<Site>& init_basis);
 
+    /// Construct with a lattice, Cartesian coordinates of each basis site (as columns), and the
+    /// species id of each site (see species.hpp). Throws std::invalid_argument if the number of sites
+    /// doesn't match, or if any id was never registered.
+    Structure(const Lattice& init_lat,
+              const Eigen::Matrix3Xd& init_cart_coords,
+              const std::vector<int>& init_species_ids);
+
     /// Returns a copy of the current lattice of the structure
     const Lattice& lattice() const;
 
@@ -50,51 +70,93 @@ public:
     /// Moves the basis sites within the lattice cell
     void within();
 
+    // References returned by the accessors below, and by __get, are only valid until the next call to a
+    // non-const member of *this (set_lattice, within, add_site, set_species, ...). Modifying the structure
+    // may release what they point to, so copy the value if it has to outlive a modification.
+
     // TODO: Rename to basis()
-    /// Return a copy of all the basis sites
+    /// All the basis sites, built on demand (see the note on the lifetime of references above)
     const std::vector<Site>& basis_sites() const;
 
-    /// Retreive the CASM implementations of *this
+    /// Cartesian coordinates of every basis site, one column per site
+    const Eigen::Matrix3Xd& cart_coords() const;
+
+    /// Species id of every basis site (see species.hpp), in the same order as the columns of cart_coords()
+    const std::vector<int>& species_ids() const;
+
+    /// Append a new site to the end of the basis
+    void add_site(const Site& new_site);
+
+    /// Remove the basis sites at each of the given indices. The remaining sites keep their relative order.
+    /// Throws if any index is out of range.
+    void remove_sites(const std::vector<int>& site_indices);
+
+    /// Change the species that occupies the basis site at the given index, without moving it
+    void set_species(int site_index, const std::string& species_name);
+
+    /// Move the basis site at the given index to a new Cartesian coordinate, without changing its species
+    void set_cart(int site_index, const Eigen::Vector3d& new_cart_coord);
+
+    /// Retreive the CASM implementations of *this. The CASM representations are only
+    /// constructed (and cached) the first time they're requested after a modification,
+    /// which also means a modification invalidates any reference to them (see above).
     template <typename CASMType> const CASMType& __get() const;
 
 private:
-    ///  updates the appropriate members using
-    /// the template type given as a reference
-    template <typename StructureRepresentation> void _update_using();
-    ///  updates the casm_simplestructure member
-    /// using casm_basicstructure as a reference
-    void _update_simple_from_basic();
-    ///  updates the casm_basicstructure member
-    /// using casm_simplestructure as a reference
-    void _update_basic_from_simple();
-
     ///  updates the lattice and basis member
-    /// using casm_simplestructure as a reference
-    void _update_internals_from_simple();
+    /// using the given CASM::SimpleStructure as a reference
+    void _update_internals_from_simple(const CASM::xtal::SimpleStructure& simple_struc);
 
     ///  updates the lattice and basis member
-    /// using casm_basicstructure as a reference
-    void _update_internals_from_basic();
+    /// using the given CASM::BasicStructure as a reference
+    void _update_internals_from_basic(const CASM::xtal::BasicStructure& basic_struc);
 
-    ///  updates casm_basicstructure
+    ///  creates a CASM::BasicStructure
     /// using the lattice and basis member as a reference
-    void _update_basic_from_internals();
+    CASM::xtal::BasicStructure _make_basic_from_internals() const;
 
-    ///  updates casm_simplestructure
+    ///  creates a CASM::SimpleStructure
     /// using the lattice and basis member as a reference
-    void _update_simple_from_internals();
+    CASM::xtal::SimpleStructure _make_simple_from_internals() const;
+
+    /// Throws if the given index doesn't correspond to a basis site
+    void _assert_valid_site_index(int site_index) const;
 
-    /// CASM::SimpleStructure representation
-    CASM::xtal::SimpleStructure casm_simplestructure;
+    /// Updates a single basis site in every representation that has already been built
+    void _update_single_site(int site_index);
 
-    /// CASM::SimpleStructure representation
-    CASM::xtal::BasicStructure casm_basicstructure;
+    /// The CASM version of the basis site at the given index, with every occupant it allows
+    CASM::xtal::Site _make_casm_site(int site_index, const CASM::xtal::Lattice& casm_lattice) const;
 
-    /// rewrap representation of the basis
-    std::vector<Site> basis;
+    /// Marks the CASM representations (and the Site view of the basis) as out of date. Call this
+    /// any time the lattice or basis members are modified.
+    void _invalidate_casm_representations();
 
-    /// rewrap representation of the lattice
+    /// rewrap representation of the lattice, this is the authoritative state of the structure
     Lattice structure_lattice;
+
+    // The basis is shared between copies of the structure until one of them modifies it, so
+    // structures that only differ by their lattice (e.g. set_lattice with CART) hold a single basis.
+
+    /// Cartesian coordinates of the basis as columns, this is the authoritative state of the structure
+    CopyOnWrite<Eigen::Matrix3Xd> basis_cart_coords;
+
+    /// Species id of each basis site, this is the authoritative state of the structure
+    CopyOnWrite<std::vector<int>> basis_species_ids;
+
+    /// Every occupant each basis site allows, kept only for structures made from a CASM::BasicStructure
+    /// where some site allows more than one. Empty otherwise, and an empty list for a single site means
+    /// its species is its only occupant.
+    CopyOnWrite<std::vector<std::vector<CASM::xtal::Molecule>>> basis_occupants;
+
+    /// Site representation of the basis, built on demand
+    LazyCache<std::vector<Site>> basis;
+
+    /// CASM::SimpleStructure representation, built on demand
+    LazyCache<CASM::xtal::SimpleStructure> casm_simplestructure;
+
+    /// CASM::BasicStructure representation, built on demand
+    LazyCache<CASM::xtal::BasicStructure> casm_basicstructure;
 };
 
 } // namespace xtal
@@ -2,6 +2,10 @@
 #define STRUCTURE_TOOLS_HH
 
 #include <casmutils/xtal/structure.hpp>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace casmutils
 {
@@ -19,6 +23,50 @@ void write_poscar(const Structure& printable, const fs::path& filename);
 /// Given a Structure, print out its information to the given stream in a vasp compatible format
 void print_poscar(const Structure& printable, std::ostream& outstream);
 
+/// Given a Structure, write out its information in a vasp compatible format into the buffer, replacing
+/// whatever was there. Reusing the same buffer for many structures avoids allocating each time.
+void format_poscar(const Structure& printable, std::string* poscar_buffer);
+
+/// Outcome of reading a single file out of many. Holds either the structure, or the reason it couldn't be read.
+struct StructureReadResult
+{
+    fs::path path;
+    std::optional<Structure> structure;
+    std::string error;
+
+    bool ok() const { return this->structure.has_value(); }
+};
+
+/// Read every POSCAR like file concurrently, using the given number of threads (0 means as many as
+/// the machine has). Results come back in the same order as the paths. A file that can't be read
+/// doesn't stop the others, its error is kept in the result instead.
+std::vector<StructureReadResult> read_structures(const std::vector<fs::path>& poscar_paths, int n_threads = 0);
+
+/// Read every file that matches the glob pattern (e.g. "shift_*/cleave_*/POSCAR"), or every file
+/// inside the directory if the pattern is a directory. Results are sorted by path.
+std::vector<StructureReadResult> read_structures_matching(const std::string& glob_pattern, int n_threads = 0);
+
+/// List every path that matches the glob pattern, sorted. A directory gives every regular file inside of it.
+std::vector<fs::path> glob_paths(const std::string& glob_pattern);
+
+/// Read a list of paths from a batch file, one per line. Blank lines are skipped.
+std::vector<fs::path> read_batch_file(const fs::path& batch_path);
+
+/// Reads the paths of a batch file (see read_batch_file) a few at a time, so that a batch file
+/// with millions of lines never has to be held in memory all at once.
+class BatchFileReader
+{
+public:
+    /// Throws if the batch file can't be opened
+    BatchFileReader(const fs::path& batch_path);
+
+    /// The next paths in the file, up to max_paths of them. Empty once the whole file has been read.
+    std::vector<fs::path> next(std::size_t max_paths);
+
+private:
+    std::ifstream batch_file;
+};
+
 /// Return a copy of the given Structure that has been converted to its standard niggli form
 Structure make_niggli(const Structure& non_niggli);
 
@@ -3,6 +3,7 @@
 #include <casmutils/mapping/structure_mapping.hpp>
 #include <casmutils/xtal/coordinate.hpp>
 #include <fstream>
+#include <optional>
 #include <string>
 
 #include <pybind11/eigen.h>
@@ -38,10 +39,39 @@ PYBIND11_MODULE(_mapping, m)
             .def_readonly("lattice_cost", &mapping::MappingReport::lattice_cost)
             .def_readonly("basis_cost", &mapping::MappingReport::basis_cost)
             .def_readonly("cost", &mapping::MappingReport::cost)
+            .def_readonly("valid", &mapping::MappingReport::valid)
+            .def_readonly("reason", &mapping::MappingReport::reason)
             .def_readonly("reference_lattice", &mapping::MappingReport::reference_lattice)
             .def_readonly("mapped_lattice", &mapping::MappingReport::mapped_lattice);
     }
 
+    {
+        class_<mapping::CompactMappingReport>(m, "CompactMappingReport")
+            .def_readonly("isometry", &mapping::CompactMappingReport::isometry)
+            .def_readonly("stretch", &mapping::CompactMappingReport::stretch)
+            .def_readonly("translation", &mapping::CompactMappingReport::translation)
+            .def_readonly("displacement", &mapping::CompactMappingReport::displacement)
+            .def_readonly("permutation", &mapping::CompactMappingReport::permutation)
+            .def_readonly("lattice_cost", &mapping::CompactMappingReport::lattice_cost)
+            .def_readonly("basis_cost", &mapping::CompactMappingReport::basis_cost)
+            .def_readonly("cost", &mapping::CompactMappingReport::cost)
+            .def_readonly("valid", &mapping::CompactMappingReport::valid)
+            .def_readonly("reason", &mapping::CompactMappingReport::reason)
+            .def_readonly("reference_lattice", &mapping::CompactMappingReport::reference_lattice)
+            .def_readonly("mapped_lattice", &mapping::CompactMappingReport::mapped_lattice)
+            .def("expand",
+                 [](const mapping::CompactMappingReport& compact_report) {
+                     return mapping::MappingReport(compact_report);
+                 });
+    }
+
+    {
+        class_<mapping::MappingResult>(m, "MappingResult")
+            .def_readonly("reports", &mapping::MappingResult::reports)
+            .def_readonly("error", &mapping::MappingResult::error)
+            .def("ok", &mapping::MappingResult::ok);
+    }
+
     {
         class_<mapping::MappingInput>(m, "MappingInput")
             .def(init<>())
@@ -58,7 +88,22 @@ PYBIND11_MODULE(_mapping, m)
             .def_readwrite("assume_ideal_lattice", &mapping::MappingInput::assume_ideal_lattice)
             .def_readwrite("assume_ideal_structure", &mapping::MappingInput::assume_ideal_structure)
             .def_readwrite("use_crystal_symmetry", &mapping::MappingInput::use_crystal_symmetry)
-            .def_readwrite("options", &mapping::MappingInput::options);
+            .def_readwrite("options", &mapping::MappingInput::options)
+            .def_readwrite("cache_size", &mapping::MappingInput::cache_size)
+            .def_readwrite("collect_stats", &mapping::MappingInput::collect_stats);
+    }
+
+    {
+        class_<mapping::MappingStats>(m, "MappingStats")
+            .def_readonly("structures", &mapping::MappingStats::structures)
+            .def_readonly("cache_hits", &mapping::MappingStats::cache_hits)
+            .def_readonly("nodes_found", &mapping::MappingStats::nodes_found)
+            .def_readonly("ruled_out_early", &mapping::MappingStats::ruled_out_early)
+            .def_readonly("report_bytes", &mapping::MappingStats::report_bytes)
+            .def_readonly("symmetry_seconds", &mapping::MappingStats::symmetry_seconds)
+            .def_readonly("cache_seconds", &mapping::MappingStats::cache_seconds)
+            .def_readonly("search_seconds", &mapping::MappingStats::search_seconds)
+            .def_readonly("report_seconds", &mapping::MappingStats::report_seconds);
     }
 
     {
@@ -67,10 +112,68 @@ PYBIND11_MODULE(_mapping, m)
                       const mapping::MappingInput&,
                       const std::vector<sym::CartOp>&,
                       const mapping::StructureMapper_f::AllowedSpeciesType&>())
-            .def("__call__", &mapping::StructureMapper_f::operator());
+            .def("__call__", &mapping::StructureMapper_f::operator())
+            .def("map_compact", &mapping::StructureMapper_f::map_compact)
+            .def("save",
+                 [](const mapping::StructureMapper_f& mapper, const std::string& prepared_path) {
+                     mapper.save(prepared_path);
+                 })
+            .def_static("load",
+                        [](const std::string& prepared_path) {
+                            return mapping::StructureMapper_f::load(prepared_path);
+                        })
+            .def("enumerate", &mapping::StructureMapper_f::enumerate, keep_alive<0, 1>())
+            .def("is_equivalent",
+                 pybind11::overload_cast<const xtal::Structure&>(&mapping::StructureMapper_f::is_equivalent,
+                                                                 pybind11::const_))
+            .def("map_many",
+                 &mapping::StructureMapper_f::map_many,
+                 arg("mappable_strucs"),
+                 arg("n_threads") = 0,
+                 call_guard<gil_scoped_release>())
+            .def("try_map_many",
+                 &mapping::StructureMapper_f::try_map_many,
+                 arg("mappable_strucs"),
+                 arg("n_threads") = 0,
+                 call_guard<gil_scoped_release>())
+            .def("cache_hits", &mapping::StructureMapper_f::cache_hits)
+            .def("cache_misses", &mapping::StructureMapper_f::cache_misses)
+            .def("cache_size", &mapping::StructureMapper_f::cache_size)
+            .def("stats", &mapping::StructureMapper_f::stats)
+            .def("reset_stats", &mapping::StructureMapper_f::reset_stats);
+    }
+
+    {
+        class_<mapping::MappingEnumerator>(m, "MappingEnumerator")
+            .def("__iter__",
+                 [](mapping::MappingEnumerator& enumerator) -> mapping::MappingEnumerator& { return enumerator; },
+                 return_value_policy::reference_internal)
+            .def("__next__", [](mapping::MappingEnumerator& enumerator) {
+                std::optional<mapping::MappingReport> report = enumerator.next();
+                if (!report)
+                {
+                    throw stop_iteration();
+                }
+                return *report;
+            });
+    }
+
+    {
+        class_<mapping::StructureEquals_f>(m, "StructureEquals_f")
+            .def(init<const mapping::MappingInput&>())
+            .def("__call__", &mapping::StructureEquals_f::operator());
     }
 
     m.def("structure_score", &mapping::structure_score);
-    m.def("map_structure", &mapping::map_structure);
+    m.def(
+        "map_structure",
+        [](const xtal::Structure& map_reference_struc,
+           const xtal::Structure& mappable_struc,
+           const std::string& cache_dir) {
+            return mapping::map_structure(map_reference_struc, mappable_struc, cache_dir);
+        },
+        arg("map_reference_struc"),
+        arg("mappable_struc"),
+        arg("cache_dir") = "");
 }
 } // namespace wrappy
@@ -20,7 +20,7 @@ def structure_score(mapping_data):
     return _mapping.structure_score(mapping_data._pybind_value)
 
 
-def map_structure(reference_struc, mapped_struc):
+def map_structure(reference_struc, mapped_struc, cache_dir=""):
     """Using the default parameters for the StructureMapper, return a MappingReport report
     that maps one structure onto the other
 
@@ -28,6 +28,9 @@ def map_structure(reference_struc, mapped_struc):
     ----------
     reference_struc : xtal.Structure
     mapped_struc : xtal.Structure
+    cache_dir : string, optional
+        Directory to keep prepared mappers in, so that mapping
+        onto the same reference again skips preparing the mapper
 
     Returns
     -------
@@ -36,5 +39,6 @@ def map_structure(reference_struc, mapped_struc):
     """
     return [
         MappingReport(r) for r in _mapping.map_structure(
-            reference_struc._pybind_value, mapped_struc._pybind_value)
+            reference_struc._pybind_value, mapped_struc._pybind_value,
+            cache_dir)
     ]
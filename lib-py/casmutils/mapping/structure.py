@@ -17,6 +17,8 @@ class MappingReport():
         self.lattice_cost = self._pybind_value.lattice_cost
         self.basis_cost = self._pybind_value.basis_cost
         self.cost = self._pybind_value.cost
+        self.valid = self._pybind_value.valid
+        self.reason = self._pybind_value.reason
         self.reference_lattice = self._pybind_value.reference_lattice
         self.mapped_lattice = self._pybind_value.mapped_lattice
 
@@ -55,6 +57,11 @@ class MappingReport():
         as_str += str(self.cost)
         as_str += "\n\n"
 
+        if not self.valid:
+            as_str += "invalid:\n"
+            as_str += self.reason
+            as_str += "\n\n"
+
         as_str += "reference lattice:\n"
         as_str += self.reference_lattice.__str__()
         as_str += "\n\n"
@@ -118,6 +125,8 @@ class MappingInput(_mapping.MappingInput):
         assume_ideal_structure : bool, optional
         assume_ideal_lattice : bool, optional
         use_crystal_symmetry : bool, optional
+        cache_size : int, optional
+        collect_stats : bool, optional
 
         """
         _mapping.MappingInput.__init__(self)
@@ -148,7 +157,10 @@ class MappingInput(_mapping.MappingInput):
             self.assume_ideal_structure) + "\n\n"
         as_str += "assume_ideal_lattice:\n" + str(
             self.assume_ideal_lattice) + "\n\n"
-        as_str += "use_crystal_symmetry:\n" + str(self.use_crystal_symmetry)
+        as_str += "use_crystal_symmetry:\n" + str(
+            self.use_crystal_symmetry) + "\n\n"
+        as_str += "cache_size:\n" + str(self.cache_size) + "\n\n"
+        as_str += "collect_stats:\n" + str(self.collect_stats)
 
         return as_str
 
@@ -202,3 +214,179 @@ class StructureMapper:
             MappingReport(r)
             for r in self._pybind_value(structure._pybind_value)
         ]
+
+    def save(self, prepared_path):
+        """Writes everything the mapper was prepared from
+        (reference structure, mapping input, factor group and
+        allowed species) to a JSON file, so that it can be
+        loaded later without working out the factor group again.
+
+        Parameters
+        ----------
+        prepared_path : string
+
+        """
+        self._pybind_value.save(prepared_path)
+
+    @classmethod
+    def load(cls, prepared_path):
+        """Makes a mapper from a file written by save
+
+        Parameters
+        ----------
+        prepared_path : string
+
+        Returns
+        -------
+        StructureMapper
+
+        """
+        mapper = cls.__new__(cls)
+        mapper._pybind_value = _mapping.StructureMapper_f.load(prepared_path)
+        return mapper
+
+    def map_compact(self, structure):
+        """Same maps as calling the mapper, as compact reports
+        that take up less memory, for when many of them have
+        to be kept. The lattices of a compact report are plain
+        3x3 column vector matrices. Use MappingReport(r.expand())
+        to get the full report back.
+
+        Parameters
+        ----------
+        structure : xtal.Structure
+
+        Returns
+        -------
+        list[_mapping.CompactMappingReport]
+
+        """
+        return self._pybind_value.map_compact(structure._pybind_value)
+
+    def enumerate(self, structure):
+        """Yields the maps of the structure onto the reference,
+        cheapest first. Maps are only computed as they're asked
+        for, so stopping early never pays for the rest, and there
+        is no need to settle on k_best_maps up front.
+
+        Parameters
+        ----------
+        structure : xtal.Structure
+
+        Yields
+        ------
+        MappingReport
+
+        """
+        for r in self._pybind_value.enumerate(structure._pybind_value):
+            yield MappingReport(r)
+
+    def is_equivalent(self, structure):
+        """Returns True if the structure maps onto the reference
+        structure with a cost of at most min_cost (or tol if
+        min_cost isn't positive). Much faster than calling the
+        mapper when only a yes or no answer is needed.
+
+        Parameters
+        ----------
+        structure : xtal.Structure
+
+        Returns
+        -------
+        bool
+
+        """
+        return self._pybind_value.is_equivalent(structure._pybind_value)
+
+    def map_many(self, structures, n_threads=0):
+        """Map every structure onto the reference structure at once,
+        spreading the work over several threads. Gives the same
+        result as calling the mapper on each structure.
+
+        Parameters
+        ----------
+        structures : list[xtal.Structure]
+        n_threads : int
+            Number of threads to use, 0 uses every core
+
+        Returns
+        -------
+        list[list[MappingReport]]
+            The reports of each structure, in the same order as structures
+
+        """
+        all_reports = self._pybind_value.map_many(
+            [s._pybind_value for s in structures], n_threads)
+        return [[MappingReport(r) for r in reports] for reports in all_reports]
+
+    def try_map_many(self, structures, n_threads=0):
+        """Same as map_many, but a structure that can't be mapped
+        doesn't stop the others, and nothing is raised.
+
+        Parameters
+        ----------
+        structures : list[xtal.Structure]
+        n_threads : int
+            Number of threads to use, 0 uses every core
+
+        Returns
+        -------
+        list[list[MappingReport] or None], list[string]
+            The reports of each structure, in the same order as
+            structures (None if it couldn't be mapped), and the
+            reason each structure couldn't be mapped (empty if it was)
+
+        """
+        results = self._pybind_value.try_map_many(
+            [s._pybind_value for s in structures], n_threads)
+        all_reports = [[MappingReport(r) for r in result.reports]
+                       if result.ok() else None for result in results]
+        errors = [result.error for result in results]
+        return all_reports, errors
+
+    def cache_stats(self):
+        """Returns how often a map was answered by the cache of
+        recently mapped structures (hits), how often it had to
+        be computed (misses), and how many structures are in
+        the cache. The cache is only enabled if the mapper was
+        constructed with a cache_size.
+
+        Returns
+        -------
+        dict[str, int]
+
+        """
+        return {
+            "hits": self._pybind_value.cache_hits(),
+            "misses": self._pybind_value.cache_misses(),
+            "size": self._pybind_value.cache_size()
+        }
+
+    def stats(self):
+        """Returns where the time of every map since the mapper was
+        constructed (or since reset_stats) went, and how much work
+        was done. Counts are ints and times are in seconds. Stats are
+        only collected if the mapper was constructed with collect_stats,
+        otherwise everything is zero.
+
+        Returns
+        -------
+        dict[str, int or float]
+
+        """
+        totals = self._pybind_value.stats()
+        return {
+            "structures": totals.structures,
+            "cache_hits": totals.cache_hits,
+            "nodes_found": totals.nodes_found,
+            "ruled_out_early": totals.ruled_out_early,
+            "report_bytes": totals.report_bytes,
+            "symmetry_seconds": totals.symmetry_seconds,
+            "cache_seconds": totals.cache_seconds,
+            "search_seconds": totals.search_seconds,
+            "report_seconds": totals.report_seconds
+        }
+
+    def reset_stats(self):
+        """Sets every count and time returned by stats back to zero"""
+        self._pybind_value.reset_stats()
@@ -26,6 +26,11 @@ std::string __str__(const xtal::Structure& printable)
 
 xtal::Structure from_poscar(const std::string& filename) { return xtal::Structure::from_poscar(filename); }
 
+xtal::Structure from_poscar_string(const std::string& poscar_text)
+{
+    return xtal::Structure::from_poscar_string(poscar_text);
+}
+
 void to_poscar(const xtal::Structure& writeable, const std::string& filename)
 {
     casmutils::xtal::write_poscar(writeable, filename);
@@ -18,6 +18,7 @@ using namespace casmutils;
 namespace Structure
 {
 xtal::Structure from_poscar(const std::string& filename);
+xtal::Structure from_poscar_string(const std::string& poscar_text);
 
 void to_poscar(const xtal::Structure& writeable, const std::string& filename);
 
@@ -5,7 +5,9 @@
 #include "casmutils/xtal/lattice.hpp"
 
 #include <casmutils/sym/cartesian.hpp>
+#include <casmutils/xtal/archive.hpp>
 #include <casmutils/xtal/coordinate.hpp>
+#include <casmutils/xtal/fingerprint.hpp>
 #include <casmutils/xtal/rocksalttoggler.hpp>
 #include <casmutils/xtal/structure.hpp>
 #include <casmutils/xtal/structure_tools.hpp>
@@ -23,6 +25,16 @@
 namespace wrappy
 {
 using namespace casmutils;
+
+/// Python users store coordinates as rows, wrap the batched functions (which store them as columns)
+/// so that they take and return Nx3 arrays
+template <typename BatchFunction> auto batch_row_coordinates(BatchFunction batch_function)
+{
+    return [batch_function](const Eigen::MatrixX3d& row_coordinates, const xtal::Lattice& lat) -> Eigen::MatrixX3d {
+        return batch_function(row_coordinates.transpose(), lat).transpose();
+    };
+}
+
 PYBIND11_MODULE(_xtal, m)
 {
     using namespace pybind11;
@@ -35,13 +47,46 @@ PYBIND11_MODULE(_xtal, m)
             .def(init<const xtal::Lattice&, const std::vector<xtal::Site>&>())
             .def("__str__", __str__)
             .def_static("_from_poscar", from_poscar)
+            .def_static("_from_poscar_string", from_poscar_string)
             .def("_to_poscar", to_poscar)
             .def("_lattice_const", &xtal::Structure::lattice)
             .def("_set_lattice_const", set_lattice_const)
             .def("_set_lattice", set_lattice)
             .def("_within", &xtal::Structure::within)
             .def("_basis_sites_const", &xtal::Structure::basis_sites)
+            .def("_cart_coords_const", &xtal::Structure::cart_coords)
+            .def("_species_ids_const", &xtal::Structure::species_ids)
+            .def("_add_site", &xtal::Structure::add_site)
+            .def("_remove_sites", &xtal::Structure::remove_sites)
+            .def("_set_species", &xtal::Structure::set_species)
+            .def("_set_cart", &xtal::Structure::set_cart)
             .def("make_niggli", pybind11::overload_cast<const xtal::Structure&>(casmutils::xtal::make_niggli));
+
+        class_<xtal::StructureReadResult>(m, "StructureReadResult")
+            .def_property_readonly("path", [](const xtal::StructureReadResult& result) { return result.path.string(); })
+            .def_readonly("structure", &xtal::StructureReadResult::structure)
+            .def_readonly("error", &xtal::StructureReadResult::error)
+            .def("ok", &xtal::StructureReadResult::ok);
+
+        // Reading doesn't touch any python objects, so other python threads can keep going
+        m.def("_read_structures",
+              [](const std::vector<std::string>& poscar_paths, int n_threads) {
+                  return xtal::read_structures(std::vector<fs::path>(poscar_paths.begin(), poscar_paths.end()),
+                                               n_threads);
+              },
+              call_guard<gil_scoped_release>());
+        m.def("_read_structures_matching", xtal::read_structures_matching, call_guard<gil_scoped_release>());
+
+        class_<xtal::StructureFingerprint>(m, "StructureFingerprint")
+            .def_readonly("composition_hash", &xtal::StructureFingerprint::composition_hash)
+            .def_readonly("volume_per_atom", &xtal::StructureFingerprint::volume_per_atom)
+            .def_readonly("distance_histogram", &xtal::StructureFingerprint::distance_histogram)
+            .def_readonly("tol", &xtal::StructureFingerprint::tol)
+            .def("__hash__", &xtal::StructureFingerprint::hash)
+            .def("hash", &xtal::StructureFingerprint::hash);
+
+        m.def("_fingerprint", xtal::fingerprint);
+        m.def("could_be_equivalent", xtal::could_be_equivalent);
     }
 
     {
@@ -72,6 +117,12 @@ PYBIND11_MODULE(_xtal, m)
     m.def("bring_within_lattice", casmutils::xtal::bring_within_lattice);
     m.def("bring_within_wigner_seitz", casmutils::xtal::bring_within_wigner_seitz);
 
+    // Batched versions, these get picked up when an Nx3 array (one coordinate per row) is given
+    m.def("fractional_to_cartesian", batch_row_coordinates(casmutils::xtal::fractional_to_cartesian_batch));
+    m.def("cartesian_to_fractional", batch_row_coordinates(casmutils::xtal::cartesian_to_fractional_batch));
+    m.def("bring_within_lattice", batch_row_coordinates(casmutils::xtal::bring_within_lattice_batch));
+    m.def("bring_within_wigner_seitz", batch_row_coordinates(casmutils::xtal::bring_within_wigner_seitz_batch));
+
     {
         class_<xtal::CoordinateEquals_f>(m, "CoordinateEquals_f")
             .def(init<double>())
@@ -119,6 +170,28 @@ PYBIND11_MODULE(_xtal, m)
             .def_static("primitive_structure", &RSOT::primitive_structure);
     }
 
+    {
+        typedef xtal::StructureArchiveWriter SAW;
+        class_<SAW>(m, "StructureArchiveWriter")
+            .def(init<const std::string&>())
+            .def("append", &SAW::append, arg("key"), arg("structure"), arg("metadata") = xtal::ArchiveMetadata())
+            .def("close", &SAW::close)
+            .def("__len__", &SAW::size);
+
+        typedef xtal::StructureArchiveReader SAR;
+        class_<SAR>(m, "StructureArchiveReader")
+            .def(init<const std::string&>())
+            .def("__len__", &SAR::size)
+            .def("__contains__", &SAR::contains)
+            .def("keys", &SAR::keys)
+            .def("_structure", overload_cast<const std::string&>(&SAR::structure, const_))
+            .def("_structure_at", overload_cast<std::size_t>(&SAR::structure, const_))
+            .def("metadata", &SAR::metadata)
+            .def("export_poscar", [](const SAR& archive, const std::string& key, const std::string& poscar_path) {
+                archive.export_poscar(key, poscar_path);
+            });
+    }
+
     // clang-format off
     m.def("make_superstructure", casmutils::xtal::make_superstructure);
     m.def("make_primitive", casmutils::xtal::make_primitive);
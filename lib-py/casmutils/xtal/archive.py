@@ -0,0 +1,128 @@
+from . import _xtal
+from .structure import Structure
+
+
+class StructureArchiveWriter():
+    """Appends structures to a single file archive,
+    creating the archive if it doesn't exist yet.
+    New structures only show up in the archive once
+    the writer is closed, which happens automatically
+    when a with statement finishes without an error.
+    Until then the archive is left as it was, and a
+    writer that is never closed changes nothing."""
+    def __init__(self, archive_path):
+        """
+        Parameters
+        ----------
+        archive_path : string
+
+        """
+        self._pybind_value = _xtal.StructureArchiveWriter(archive_path)
+
+    def append(self, key, structure, metadata={}):
+        """Adds a structure to the archive
+
+        Parameters
+        ----------
+        key : string
+            Unique name of the structure within the archive
+        structure : Structure or MutableStructure
+        metadata : dict[string, float]
+            Values describing the structure, e.g. its shift or cleavage
+
+        """
+        self._pybind_value.append(key, structure._pybind_value, metadata)
+
+    def close(self):
+        """Writes the index of the archive. Nothing can
+        be appended afterwards.
+
+        """
+        self._pybind_value.close()
+
+    def __len__(self):
+        return len(self._pybind_value)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        if exc_type is None:
+            self.close()
+
+
+class StructureArchiveReader():
+    """Random access to the structures of an archive.
+    The archive is memory mapped, so only the structures
+    that are asked for are ever read."""
+    def __init__(self, archive_path):
+        """
+        Parameters
+        ----------
+        archive_path : string
+
+        """
+        self._pybind_value = _xtal.StructureArchiveReader(archive_path)
+
+    def keys(self):
+        """Returns the key of every structure, in the
+        order they were appended
+
+        Returns
+        -------
+        list[string]
+
+        """
+        return self._pybind_value.keys()
+
+    def structure(self, key):
+        """Reads a single structure from the archive
+
+        Parameters
+        ----------
+        key : string or int
+            Key of the structure, or its position in the archive
+
+        Returns
+        -------
+        Structure
+
+        """
+        if isinstance(key, int):
+            return Structure._from_pybind(self._pybind_value._structure_at(key))
+        return Structure._from_pybind(self._pybind_value._structure(key))
+
+    def metadata(self, key):
+        """Returns the values that were stored with the structure
+
+        Parameters
+        ----------
+        key : string
+
+        Returns
+        -------
+        dict[string, float]
+
+        """
+        return self._pybind_value.metadata(key)
+
+    def export_poscar(self, key, poscar_path):
+        """Writes a single structure of the archive
+        out as a POSCAR file
+
+        Parameters
+        ----------
+        key : string
+        poscar_path : string
+
+        """
+        self._pybind_value.export_poscar(key, poscar_path)
+
+    def __len__(self):
+        return len(self._pybind_value)
+
+    def __contains__(self, key):
+        return key in self._pybind_value
+
+    def __getitem__(self, key):
+        return self.structure(key)
@@ -261,6 +261,7 @@ def cartesian_to_fractional(cart_coords, lat):
     Parameters
     ----------
     cart_coords : np.array
+        Either a single coordinate, or an Nx3 array with one coordinate per row
     lat : cu.xtal.Lattice
 
     Returns
@@ -277,6 +278,7 @@ def fractional_to_cartesian(frac_coords, lat):
     Parameters
     ----------
     frac_coords: np.array
+        Either a single coordinate, or an Nx3 array with one coordinate per row
     lat : cu.xtal.Lattice
 
     Returns
@@ -293,6 +295,7 @@ def bring_within_lattice(cart_coords, lat):
     Parameters
     ----------
     cart_coords : np.array
+        Either a single coordinate, or an Nx3 array with one coordinate per row
     lat : cu.xtal.Lattice
 
     Returns
@@ -309,6 +312,7 @@ def bring_within_wigner_seitz(cart_coords, lat):
     Parameters
     ----------
     cart_coords : np.array
+        Either a single coordinate, or an Nx3 array with one coordinate per row
     lat : cu.xtal.Lattice
 
     Returns
@@ -57,6 +57,55 @@ class _Structure():
         py_bind_structure = _xtal.Structure._from_poscar(poscar_path)
         return cls._from_pybind(py_bind_structure)
 
+    @classmethod
+    def read_structures(cls, poscar_paths, n_threads=0):
+        """Reads many POSCAR files concurrently. Files that
+        can't be read don't stop the others.
+
+        Parameters
+        ----------
+        poscar_paths : list[string] or string
+            Paths to each file, or a glob pattern (or directory)
+            that matches the files
+        n_threads : int
+            Number of threads to read with, 0 uses every core
+
+        Returns
+        -------
+        list[Structure or MutableStructure or None], list[string]
+            The structures in the same order as the paths (None
+            if it couldn't be read), and the reason each file
+            couldn't be read (empty if it was read)
+
+        """
+        if isinstance(poscar_paths, str):
+            results = _xtal._read_structures_matching(poscar_paths, n_threads)
+        else:
+            results = _xtal._read_structures([str(p) for p in poscar_paths], n_threads)
+
+        structures = [
+            cls._from_pybind(r.structure) if r.ok() else None for r in results
+        ]
+        errors = [r.error for r in results]
+        return structures, errors
+
+    @classmethod
+    def from_poscar_string(cls, poscar_text):
+        """Reads the text of a POSCAR and returns
+        constructed Structure
+
+        Parameters
+        ----------
+        poscar_text : string
+
+        Returns
+        -------
+        Structure or MutableStructure
+
+        """
+        py_bind_structure = _xtal.Structure._from_poscar_string(poscar_text)
+        return cls._from_pybind(py_bind_structure)
+
     def lattice(self):
         """Returns the lattice of the
         current structure
@@ -94,6 +143,28 @@ class _Structure():
 
         return basis
 
+    def cart_coords(self):
+        """Returns the Cartesian coordinates of all
+        the basis sites, one column per site
+
+        Returns
+        -------
+        np.array (3xN)
+
+        """
+        return self._pybind_value._cart_coords_const()
+
+    def species_ids(self):
+        """Returns the interned species id of each basis
+        site, in the same order as cart_coords()
+
+        Returns
+        -------
+        list[int]
+
+        """
+        return self._pybind_value._species_ids_const()
+
     def __str__(self):
         """Returns lattice and the list of basis sites as
         a printable string
@@ -181,3 +252,68 @@ class MutableStructure(_Structure):
         """
         self._pybind_value._set_lattice(new_lattice, coord_type)
         return
+
+    def add_site(self, new_site):
+        """Appends a new site to the end of the basis
+
+        Parameters
+        ----------
+        new_site : Site or MutableSite
+
+        Returns
+        -------
+        None
+
+        """
+        self._pybind_value._add_site(new_site._pybind_value)
+        return
+
+    def remove_sites(self, site_indices):
+        """Removes the basis sites at each of the given
+        indices, keeping the order of the remaining sites
+
+        Parameters
+        ----------
+        site_indices : list[int]
+
+        Returns
+        -------
+        None
+
+        """
+        self._pybind_value._remove_sites(site_indices)
+        return
+
+    def set_species(self, site_index, species_name):
+        """Changes the species of the basis site at
+        the given index, without moving it
+
+        Parameters
+        ----------
+        site_index : int
+        species_name : string
+
+        Returns
+        -------
+        None
+
+        """
+        self._pybind_value._set_species(site_index, species_name)
+        return
+
+    def set_cart(self, site_index, new_cart_coord):
+        """Moves the basis site at the given index to the
+        given Cartesian coordinate, without changing its species
+
+        Parameters
+        ----------
+        site_index : int
+        new_cart_coord : np.array
+
+        Returns
+        -------
+        None
+
+        """
+        self._pybind_value._set_cart(site_index, new_cart_coord)
+        return
@@ -6,11 +6,14 @@ from .coordinate import MutableCoordinate
 from .lattice import *
 from .site import *
 from .structure import *
+from .archive import *
 from .symmetry import *
 from .globaldef import *
 from ._xtal import make_niggli as _make_niggli
 from ._xtal import make_superstructure as _make_superstructure
 from ._xtal import make_primitive as _make_primitive
+from ._xtal import _fingerprint
+from ._xtal import could_be_equivalent
 
 # from .single_block_wadsley_roth import *
 
@@ -58,4 +61,19 @@ def make_primitive(structure):
     return Structure._from_pybind(_make_primitive(structure._pybind_value))
 
 
+def fingerprint(structure, tol):
+    """Returns a cheap summary of the structure that doesn't change with
+    rotations, translations, the order of the basis, or the choice of
+    supercell. Structures whose fingerprints aren't could_be_equivalent
+    can't be equivalent, and equivalent structures nearly always share
+    the same hash().
+
+    :structure: casmutils.xtal.structure.Structure
+    :tol: float
+    :returns: StructureFingerprint
+
+    """
+    return _fingerprint(structure._pybind_value, tol)
+
+
 Coordinate.extra_function = extra_function
@@ -1,8 +1,21 @@
 #include "casmutils/sym/cartesian.hpp"
 #include <casm/crystallography/LatticeMap.hh>
 #include <casmutils/mapping/structure_mapping.hpp>
+#include <casmutils/parallel.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <sstream>
+#include <unordered_map>
 #include <vector>
 
+#include <casmutils/xtal/species.hpp>
 #include <casmutils/xtal/structure_tools.hpp>
 #include <casmutils/xtal/symmetry.hpp>
 namespace casmutils
@@ -38,13 +51,649 @@ double atomic_cost(const MappingReport& mapped_result, int Nsites)
     return (atomic_cost_child(mapped_result, Nsites) + atomic_cost_parent(mapped_result, Nsites)) / 2.;
 }
 
+//*******************************************************************************************
+
+/// Maps that cost at most this much mean the two structures are equivalent
+double equivalence_cost(const MappingInput& settings)
+{
+    return settings.min_cost > 0 ? settings.min_cost : settings.tol;
+}
+
+/// Bound on how far any principal stretch of a map within the equivalence threshold can be from 1,
+/// once the change in volume is divided out. The lattice cost is a third of the squared norm of
+/// U/det(U)^(1/3) - I, where U is the stretch, so it never sees the volume, and it only makes up a
+/// strain_weight part of the total cost.
+double equivalent_stretch_bound(const MappingInput& settings)
+{
+    return std::sqrt(3 * equivalence_cost(settings) / settings.strain_weight);
+}
+
+/// Bound on how much any distance between two atoms can change in a map within the equivalence threshold,
+/// once both structures are scaled to a volume per atom of 1. Distances change by at most the stretch bound
+/// times their length, plus twice the largest displacement of a single atom. The result is a tolerance
+/// for xtal::fingerprint, which allows distances to change by (2 + distance) times the tolerance.
+double equivalent_distance_bound(int n_atoms, const MappingInput& settings, double length_unit)
+{
+    // The basis cost is the average of the mean square displacements measured in either structure, in units
+    // of the radius of a sphere with the volume per atom, so neither can be more than twice the basis cost.
+    // All of it can be on a single atom, and it only makes up a (1-strain_weight) part of the total cost.
+    // Going from either structure to the other scales displacements by at most one plus the stretch bound.
+    double max_stretch = equivalent_stretch_bound(settings);
+    double max_basis_cost = equivalence_cost(settings) / (1 - settings.strain_weight);
+    double atomic_radius = std::cbrt(3 / (4 * M_PI));
+    double max_displacement = std::sqrt(2 * max_basis_cost * n_atoms) * atomic_radius + settings.tol / length_unit;
+    return std::max(max_stretch, (1 + max_stretch) * max_displacement);
+}
+
+/// The tolerance of an equivalence fingerprint grows with the number of atoms in the map, so a fingerprint made
+/// for a smaller structure (e.g. the primitive reference) gets loosened before it's compared to a superstructure
+xtal::StructureFingerprint loosened_fingerprint(xtal::StructureFingerprint fingerprint, double tol)
+{
+    if (tol > fingerprint.tol)
+    {
+        for (double& bin_tol : fingerprint.histogram_tolerance)
+        {
+            bin_tol *= tol / fingerprint.tol;
+        }
+        fingerprint.tol = tol;
+    }
+    return fingerprint;
+}
+
+/// Measures the time between laps, but only reads the clock if it's running, so that stats
+/// cost nothing when they aren't being collected
+class Stopwatch
+{
+public:
+    explicit Stopwatch(bool is_running) : is_running(is_running)
+    {
+        if (is_running)
+        {
+            last_lap = std::chrono::steady_clock::now();
+        }
+    }
+
+    /// Seconds since the last lap (or since the stopwatch was made), or 0 if it isn't running
+    double lap()
+    {
+        if (!is_running)
+        {
+            return 0;
+        }
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last_lap).count();
+        last_lap = now;
+        return seconds;
+    }
+
+private:
+    bool is_running;
+    std::chrono::steady_clock::time_point last_lap;
+};
+
+/// Memory held by the reports, including what their matrices and vectors allocate
+template <typename ReportType> std::size_t report_bytes(const std::vector<ReportType>& reports)
+{
+    std::size_t bytes = 0;
+    for (const ReportType& report : reports)
+    {
+        bytes += sizeof(ReportType) + report.displacement.size() * sizeof(double) +
+                 report.permutation.size() * sizeof(report.permutation[0]);
+    }
+    return bytes;
+}
+
+using nlohmann::json;
+
+/// 64 bit FNV-1a hash of the text. Unlike std::hash, it's the same for every build and platform, so
+/// files named after it can be found again by other builds.
+std::uint64_t stable_text_hash(const std::string& text)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (char c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+/// Identifies the files written by StructureMapper_f::save. Bump the version whenever their layout changes.
+const std::string prepared_mapper_format = "casmutils prepared mapper";
+constexpr int prepared_mapper_version = 1;
+
+/// One array per row of the matrix
+json matrix_to_json(const Eigen::MatrixXd& matrix)
+{
+    json rows = json::array();
+    for (int i = 0; i < matrix.rows(); ++i)
+    {
+        json row = json::array();
+        for (int j = 0; j < matrix.cols(); ++j)
+        {
+            row.push_back(matrix(i, j));
+        }
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+Eigen::MatrixXd matrix_from_json(const json& rows, int n_cols)
+{
+    Eigen::MatrixXd matrix(rows.size(), n_cols);
+    for (int i = 0; i < rows.size(); ++i)
+    {
+        if (rows.at(i).size() != n_cols)
+        {
+            throw except::BadPreparedMapper("expected " + std::to_string(n_cols) + " columns in every row");
+        }
+        for (int j = 0; j < n_cols; ++j)
+        {
+            matrix(i, j) = rows.at(i).at(j).get<double>();
+        }
+    }
+    return matrix;
+}
+
+Eigen::Matrix3d matrix3_from_json(const json& rows)
+{
+    if (rows.size() != 3)
+    {
+        throw except::BadPreparedMapper("expected a 3x3 matrix");
+    }
+    return matrix_from_json(rows, 3);
+}
+
+json structure_to_json(const xtal::Structure& struc)
+{
+    json species = json::array();
+    for (int id : struc.species_ids())
+    {
+        species.push_back(xtal::species_name(id));
+    }
+    return {{"lattice_vectors", matrix_to_json(struc.lattice().row_vector_matrix())},
+            {"cart_coords", matrix_to_json(struc.cart_coords().transpose())},
+            {"species", species}};
+}
+
+xtal::Structure structure_from_json(const json& struc_json)
+{
+    Eigen::Matrix3d lattice_vectors = matrix3_from_json(struc_json.at("lattice_vectors"));
+    Eigen::MatrixXd coords = matrix_from_json(struc_json.at("cart_coords"), 3);
+    std::vector<std::string> species = struc_json.at("species").get<std::vector<std::string>>();
+    if (species.size() != coords.rows())
+    {
+        throw except::BadPreparedMapper("the reference structure needs one species for every site");
+    }
+
+    std::vector<int> species_ids;
+    species_ids.reserve(species.size());
+    for (const std::string& name : species)
+    {
+        species_ids.push_back(xtal::species_id(name));
+    }
+    return xtal::Structure(xtal::Lattice::from_row_vector_matrix(lattice_vectors), coords.transpose(), species_ids);
+}
+
+/// Only the settings that change what the mapper finds are written. The cache size and whether stats get
+/// collected only matter while the mapper runs, so they're left for whoever loads it to choose.
+json input_to_json(const MappingInput& input)
+{
+    return {{"tol", input.tol},
+            {"k_best_maps", input.k_best_maps},
+            {"keep_invalid_mapping_nodes", input.keep_invalid_mapping_nodes},
+            {"strain_weight", input.strain_weight},
+            {"max_volume_change", input.max_volume_change},
+            {"min_vacancy_fraction", input.min_vacancy_fraction},
+            {"max_vacancy_fraction", input.max_vacancy_fraction},
+            {"max_cost", input.max_cost},
+            {"min_cost", input.min_cost},
+            {"impose_reference_lattice", input.impose_reference_lattice},
+            {"assume_ideal_lattice", input.assume_ideal_lattice},
+            {"assume_ideal_structure", input.assume_ideal_structure},
+            {"options", input.options},
+            {"use_crystal_symmetry", input.use_crystal_symmetry}};
+}
+
+/// Reads the settings written by input_to_json, taking the ones that aren't written from runtime_settings
+MappingInput input_from_json(const json& input_json, const MappingInput& runtime_settings)
+{
+    MappingInput input;
+    input.tol = input_json.at("tol").get<double>();
+    input.k_best_maps = input_json.at("k_best_maps").get<int>();
+    input.keep_invalid_mapping_nodes = input_json.at("keep_invalid_mapping_nodes").get<bool>();
+    input.strain_weight = input_json.at("strain_weight").get<double>();
+    input.max_volume_change = input_json.at("max_volume_change").get<double>();
+    input.min_vacancy_fraction = input_json.at("min_vacancy_fraction").get<double>();
+    input.max_vacancy_fraction = input_json.at("max_vacancy_fraction").get<double>();
+    input.max_cost = input_json.at("max_cost").get<double>();
+    input.min_cost = input_json.at("min_cost").get<double>();
+    input.impose_reference_lattice = input_json.at("impose_reference_lattice").get<bool>();
+    input.assume_ideal_lattice = input_json.at("assume_ideal_lattice").get<bool>();
+    input.assume_ideal_structure = input_json.at("assume_ideal_structure").get<bool>();
+    input.options = input_json.at("options").get<int>();
+    input.use_crystal_symmetry = input_json.at("use_crystal_symmetry").get<bool>();
+    input.cache_size = runtime_settings.cache_size;
+    input.collect_stats = runtime_settings.collect_stats;
+    return input;
+}
+
+json factor_group_to_json(const std::vector<sym::CartOp>& factor_group)
+{
+    json ops = json::array();
+    for (const sym::CartOp& op : factor_group)
+    {
+        ops.push_back({{"matrix", matrix_to_json(op.matrix)},
+                       {"translation", {op.translation(0), op.translation(1), op.translation(2)}},
+                       {"time_reversal", op.is_time_reversal_active}});
+    }
+    return ops;
+}
+
+std::vector<sym::CartOp> factor_group_from_json(const json& ops)
+{
+    std::vector<sym::CartOp> factor_group;
+    for (const json& op : ops)
+    {
+        std::vector<double> translation = op.at("translation").get<std::vector<double>>();
+        if (translation.size() != 3)
+        {
+            throw except::BadPreparedMapper("expected a translation with 3 components");
+        }
+        factor_group.emplace_back(matrix3_from_json(op.at("matrix")),
+                                  Eigen::Vector3d(translation[0], translation[1], translation[2]),
+                                  op.at("time_reversal").get<bool>());
+    }
+    return factor_group;
+}
+
+json read_prepared_json(const fs::path& prepared_path)
+{
+    std::ifstream prepared_stream(prepared_path);
+    if (!prepared_stream)
+    {
+        throw except::BadPath(prepared_path);
+    }
+
+    try
+    {
+        json prepared = json::parse(prepared_stream);
+        if (prepared.at("format") != prepared_mapper_format)
+        {
+            throw except::BadPreparedMapper(prepared_path.string() + " is not a prepared mapper");
+        }
+        if (prepared.at("version") != prepared_mapper_version)
+        {
+            throw except::BadPreparedMapper(prepared_path.string() + " was written by a different version");
+        }
+        return prepared;
+    }
+    catch (const json::exception& e)
+    {
+        throw except::BadPreparedMapper(e.what());
+    }
+}
+
+StructureMapper_f mapper_from_json(const json& prepared, const MappingInput& runtime_settings)
+{
+    std::optional<xtal::Structure> reference;
+    MappingInput input;
+    std::vector<sym::CartOp> factor_group;
+    StructureMapper_f::AllowedSpeciesType allowed_species;
+    try
+    {
+        reference = structure_from_json(prepared.at("reference"));
+        input = input_from_json(prepared.at("input"), runtime_settings);
+        factor_group = factor_group_from_json(prepared.at("factor_group"));
+        allowed_species = prepared.at("allowed_species").get<StructureMapper_f::AllowedSpeciesType>();
+    }
+    catch (const json::exception& e)
+    {
+        throw except::BadPreparedMapper(e.what());
+    }
+    return StructureMapper_f(*reference, input, factor_group, allowed_species);
+}
+
+/// Loads the mapper for the reference from the cache directory, or prepares it and saves it there for
+/// next time. Files are named prepared_mapper_<hash>.json, where the hash is the 64 bit FNV-1a hash of the
+/// serialized reference and settings, written as 16 hex digits. A file is only used if it really was
+/// prepared from the same reference and settings.
+StructureMapper_f load_or_prepare_mapper(const fs::path& cache_dir,
+                                         const xtal::Structure& reference,
+                                         const MappingInput& input)
+{
+    json reference_json = structure_to_json(reference);
+    json input_json = input_to_json(input);
+    std::uint64_t prepared_hash = stable_text_hash(reference_json.dump() + input_json.dump());
+    std::ostringstream prepared_name;
+    prepared_name << "prepared_mapper_" << std::hex << std::setw(16) << std::setfill('0') << prepared_hash << ".json";
+    fs::path prepared_path = cache_dir / prepared_name.str();
+
+    if (fs::exists(prepared_path))
+    {
+        try
+        {
+            json prepared = read_prepared_json(prepared_path);
+            if (prepared.at("reference") == reference_json && prepared.at("input") == input_json)
+            {
+                return mapper_from_json(prepared, input);
+            }
+        }
+        catch (const except::BadPreparedMapper&)
+        {
+            // Damaged or outdated files get prepared and written over again
+        }
+    }
+
+    StructureMapper_f mapper(reference, input);
+    fs::create_directories(cache_dir);
+    // Write to a file of our own first, so that nobody else ever reads a half written file
+    fs::path partial_path = prepared_path;
+    partial_path += ".partial" + std::to_string(std::random_device()());
+    mapper.save(partial_path);
+    fs::rename(partial_path, prepared_path);
+    return mapper;
+}
+
+/// The part of symmetry_preserving_mapping_report that only depends on the group, so that it's prepared
+/// once when many reports get averaged over the same group
+class SymmetryPreservingProjection
+{
+public:
+    SymmetryPreservingProjection(const std::vector<sym::CartOp>& group_as_operations,
+                                 const std::vector<sym::PermRep>& group_as_permutations)
+        : n_sites(group_as_permutations.empty() ? 0 : group_as_permutations[0].size())
+    {
+        if (group_as_operations.size() != group_as_permutations.size())
+        {
+            throw except::UserInputMangle("Every operation of the group needs exactly one permutation");
+        }
+
+        operations.reserve(group_as_operations.size());
+        destination_table.reserve(group_as_permutations.size() * n_sites);
+        for (int i = 0; i < group_as_operations.size(); ++i)
+        {
+            operations.push_back(group_as_operations[i].matrix);
+
+            std::vector<bool> is_destination(n_sites, false);
+            for (int destination : group_as_permutations[i])
+            {
+                if (group_as_permutations[i].size() != n_sites || destination < 0 || destination >= n_sites ||
+                    is_destination[destination])
+                {
+                    throw except::UserInputMangle("The permutations of the group must all reorder the same sites");
+                }
+                is_destination[destination] = true;
+                destination_table.push_back(destination);
+            }
+        }
+    }
+
+    /// Writes the symmetry preserving stretch and displacement of mapping_data into new_report, which must
+    /// start out as a copy of mapping_data. The scratch matrix is only there to be reused between calls.
+    /// The arithmetic is the same, expression for expression, as that of the original implementation,
+    /// which went through a temporary matrix per operation, so the results don't change in the last bit.
+    void project(const MappingReport& mapping_data,
+                 MappingReport* new_report,
+                 Eigen::MatrixXd* transformed_stretch) const
+    {
+        if (!operations.empty() && mapping_data.displacement.cols() != n_sites)
+        {
+            throw except::UserInputMangle("The permutations of the group don't match the sites of the mapping");
+        }
+
+        const double group_size = operations.size();
+        new_report->displacement.setZero();
+        new_report->stretch.setZero();
+        for (int i = 0; i < operations.size(); ++i)
+        {
+            const Eigen::Matrix3d& op = operations[i];
+            const int* destinations = destination_table.data() + i * n_sites;
+            for (int site = 0; site < n_sites; ++site)
+            {
+                new_report->displacement.col(destinations[site]) +=
+                    (op * mapping_data.displacement.col(site)) / group_size;
+            }
+
+            // Going through a dynamic matrix instead of a Matrix3d keeps the rounding of the stretch the same
+            transformed_stretch->noalias() = op.transpose() * mapping_data.stretch * op;
+            new_report->stretch += *transformed_stretch / group_size;
+        }
+    }
+
+private:
+    int n_sites;
+    std::vector<Eigen::Matrix3d> operations;
+
+    /// Where each site ends up under each operation, one row of n_sites entries per operation
+    std::vector<int> destination_table;
+};
+
+/// True if the lattice spanned by the columns of superlattice_mat is the mappable lattice after a rotation, i.e.
+/// if rotating each of its vectors by the closest rotation lands within tol of the mappable one
+bool is_rotated_lattice(const Eigen::Matrix3d& superlattice_mat, const Eigen::Matrix3d& mappable_mat, double tol)
+{
+    Eigen::Matrix3d deformation = mappable_mat * superlattice_mat.inverse();
+    if (deformation.determinant() <= 0)
+    {
+        return false;
+    }
+    Eigen::Matrix3d rotation = xtal::polar_decomposition(deformation).first;
+    return (rotation * superlattice_mat - mappable_mat).colwise().norm().maxCoeff() <= tol;
+}
+
+/// Integer transformation that takes the reference lattice onto a supercell that is the mappable lattice in
+/// some other orientation. Every vector of the mappable lattice is then a rotated vector of the reference
+/// lattice, so the candidates for each are the reference lattice vectors of the same length, and the three
+/// picked have to agree with the angles between the mappable vectors.
+std::optional<Eigen::Matrix3d>
+find_rotated_supercell_transformation(const xtal::Lattice& reference_lat, const xtal::Lattice& mappable_lat, double tol)
+{
+    const Eigen::Matrix3d& reference_mat = reference_lat.column_vector_matrix();
+    const Eigen::Matrix3d& inv_reference_mat = reference_lat.inverse_column_vector_matrix();
+    const Eigen::Matrix3d& mappable_mat = mappable_lat.column_vector_matrix();
+    const Eigen::Vector3d mappable_lengths = mappable_mat.colwise().norm();
+    const double max_length = mappable_lengths.maxCoeff() + tol;
+
+    // Sort every reference lattice vector within reach by which of the mappable vectors it could be
+    std::array<std::vector<Eigen::Vector3d>, 3> candidates;
+    Eigen::Vector3i image_range;
+    for (int k = 0; k < 3; ++k)
+    {
+        image_range(k) = std::ceil(max_length * inv_reference_mat.row(k).norm());
+    }
+    for (int i = -image_range(0); i <= image_range(0); ++i)
+    {
+        for (int j = -image_range(1); j <= image_range(1); ++j)
+        {
+            for (int k = -image_range(2); k <= image_range(2); ++k)
+            {
+                Eigen::Vector3d integer_coords(i, j, k);
+                double length = (reference_mat * integer_coords).norm();
+                for (int c = 0; c < 3; ++c)
+                {
+                    if (std::abs(length - mappable_lengths(c)) <= tol)
+                    {
+                        candidates[c].push_back(integer_coords);
+                    }
+                }
+            }
+        }
+    }
+
+    // Vectors that are each within tol of the rotated mappable ones can't have dot products that differ by more
+    auto dot_products_agree = [&](const Eigen::Vector3d& lhs, const Eigen::Vector3d& rhs, int lhs_ix, int rhs_ix) {
+        double reference_dot = (reference_mat * lhs).dot(reference_mat * rhs);
+        double mappable_dot = mappable_mat.col(lhs_ix).dot(mappable_mat.col(rhs_ix));
+        return std::abs(reference_dot - mappable_dot) <= tol * (max_length + max_length + tol);
+    };
+
+    // Only proper rotations are allowed, so the transformation has to keep the handedness the two lattices share
+    const bool needs_positive_determinant = mappable_lat.volume() * reference_lat.volume() > 0;
+    for (const Eigen::Vector3d& a : candidates[0])
+    {
+        for (const Eigen::Vector3d& b : candidates[1])
+        {
+            if (!dot_products_agree(a, b, 0, 1))
+            {
+                continue;
+            }
+            for (const Eigen::Vector3d& c : candidates[2])
+            {
+                Eigen::Matrix3d transformation;
+                transformation << a, b, c;
+                double determinant = transformation.determinant();
+                if (std::abs(determinant) < 0.5 || (determinant > 0) != needs_positive_determinant ||
+                    !dot_products_agree(a, c, 0, 2) || !dot_products_agree(b, c, 1, 2))
+                {
+                    continue;
+                }
+                if (is_rotated_lattice(reference_mat * transformation, mappable_mat, tol))
+                {
+                    return transformation;
+                }
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+/// The lattice node that takes the reference lattice onto the lattice of the mappable structure, if that lattice
+/// is an integer supercell of the reference (within tol), in any orientation. With the node fixed, only the
+/// assignment of the basis and the translation are left to search for.
+std::optional<CASM::xtal::LatticeNode>
+find_ideal_lattice_node(const xtal::Lattice& reference_lat, const xtal::Structure& mappable_struc, double tol)
+{
+    // Most of the time the mappable structure is in the same orientation as the reference, and rounding is enough
+    const xtal::Lattice& mappable_lat = mappable_struc.lattice();
+    Eigen::Matrix3d transformation =
+        (reference_lat.inverse_column_vector_matrix() * mappable_lat.column_vector_matrix()).array().round();
+    Eigen::Matrix3d superlattice_mat = reference_lat.column_vector_matrix() * transformation;
+    if (std::abs(transformation.determinant()) < 0.5 ||
+        (superlattice_mat - mappable_lat.column_vector_matrix()).colwise().norm().maxCoeff() > tol)
+    {
+        std::optional<Eigen::Matrix3d> rotated_transformation =
+            find_rotated_supercell_transformation(reference_lat, mappable_lat, tol);
+        if (!rotated_transformation)
+        {
+            return std::nullopt;
+        }
+        superlattice_mat = reference_lat.column_vector_matrix() * *rotated_transformation;
+    }
+
+    CASM::xtal::Lattice casm_superlattice(superlattice_mat, tol);
+    return CASM::xtal::LatticeNode(reference_lat.__get(),
+                                   casm_superlattice,
+                                   mappable_lat.__get(),
+                                   mappable_lat.__get(),
+                                   mappable_struc.species_ids().size());
+}
+
+/// Same as find_ideal_lattice_node, but throws if the lattice isn't a supercell of the reference
+CASM::xtal::LatticeNode
+make_ideal_lattice_node(const xtal::Lattice& reference_lat, const xtal::Structure& mappable_struc, double tol)
+{
+    std::optional<CASM::xtal::LatticeNode> ideal_lattice_node =
+        find_ideal_lattice_node(reference_lat, mappable_struc, tol);
+    if (!ideal_lattice_node)
+    {
+        throw except::UserInputMangle("The lattice of the mappable structure isn't a supercell of the reference "
+                                      "lattice in any orientation (within tol), so assume_ideal_lattice can't "
+                                      "be used to map it");
+    }
+    return *ideal_lattice_node;
+}
+
 } // namespace
 
+std::string invalid_map_reason(const CASM::xtal::MappingNode& casm_mapping_node)
+{
+    if (casm_mapping_node.is_valid)
+    {
+        return "";
+    }
+    if (!casm_mapping_node.is_viable)
+    {
+        return "No assignment of the basis onto the reference sites is possible";
+    }
+    return "The map fails the validity checks of the mapper options (e.g. sym_basis or sym_strain)";
+}
+
+MappingReport::MappingReport(const CompactMappingReport& compact_report)
+    : isometry(compact_report.isometry),
+      stretch(compact_report.stretch),
+      translation(compact_report.translation),
+      displacement(compact_report.displacement),
+      permutation(compact_report.permutation.begin(), compact_report.permutation.end()),
+      lattice_cost(compact_report.lattice_cost),
+      basis_cost(compact_report.basis_cost),
+      cost(compact_report.cost),
+      valid(compact_report.valid),
+      reason(compact_report.reason),
+      reference_lattice(compact_report.reference_lattice),
+      mapped_lattice(compact_report.mapped_lattice)
+{
+}
+
+CompactMappingReport::CompactMappingReport(const CASM::xtal::MappingNode& casm_mapping_node)
+    : isometry(casm_mapping_node.isometry()),
+      stretch(casm_mapping_node.stretch()),
+      translation(casm_mapping_node.translation()),
+      displacement(casm_mapping_node.atom_displacement),
+      permutation(casm_mapping_node.atom_permutation.begin(), casm_mapping_node.atom_permutation.end()),
+      lattice_cost(casm_mapping_node.lattice_node.cost),
+      basis_cost(casm_mapping_node.atomic_node.cost),
+      cost(casm_mapping_node.cost),
+      valid(casm_mapping_node.is_valid),
+      reason(invalid_map_reason(casm_mapping_node)),
+      reference_lattice(casm_mapping_node.lattice_node.parent.superlattice().lat_column_mat()),
+      mapped_lattice(casm_mapping_node.lattice_node.child.superlattice().lat_column_mat())
+{
+}
+
+CompactMappingReport::CompactMappingReport(const MappingReport& report)
+    : isometry(report.isometry),
+      stretch(report.stretch),
+      translation(report.translation),
+      displacement(report.displacement),
+      permutation(report.permutation.begin(), report.permutation.end()),
+      lattice_cost(report.lattice_cost),
+      basis_cost(report.basis_cost),
+      cost(report.cost),
+      valid(report.valid),
+      reason(report.reason),
+      reference_lattice(report.reference_lattice.column_vector_matrix()),
+      mapped_lattice(report.mapped_lattice.column_vector_matrix())
+{
+}
+
+//*******************************************************************************************
+
+MappingStats& MappingStats::operator+=(const MappingStats& other)
+{
+    structures += other.structures;
+    cache_hits += other.cache_hits;
+    nodes_found += other.nodes_found;
+    ruled_out_early += other.ruled_out_early;
+    report_bytes += other.report_bytes;
+    symmetry_seconds += other.symmetry_seconds;
+    cache_seconds += other.cache_seconds;
+    search_seconds += other.search_seconds;
+    report_seconds += other.report_seconds;
+    return *this;
+}
+
 std::vector<sym::CartOp> StructureMapper_f::make_default_factor_group() const
 {
     if (this->settings.use_crystal_symmetry)
     {
-        return xtal::make_factor_group(reference_structure, this->settings.tol);
+        Stopwatch stopwatch(this->stats_collector != nullptr);
+        std::vector<sym::CartOp> reference_factor_group =
+            xtal::make_factor_group(reference_structure, this->settings.tol);
+        MappingStats symmetry_stats;
+        symmetry_stats.symmetry_seconds = stopwatch.lap();
+        this->record_stats(symmetry_stats);
+        return reference_factor_group;
     }
 
     return {sym::CartOp::identity()};
@@ -53,11 +702,10 @@ std::vector<sym::CartOp> StructureMapper_f::make_default_factor_group() const
 StructureMapper_f::AllowedSpeciesType StructureMapper_f::make_default_allowed_species() const
 {
     AllowedSpeciesType default_allowed_species;
-    for (const auto& site : reference_structure.basis_sites())
+    default_allowed_species.reserve(reference_structure.species_ids().size());
+    for (int id : reference_structure.species_ids())
     {
-        std::vector<std::string> at_site_occs;
-        at_site_occs.push_back(site.label());
-        default_allowed_species.push_back(at_site_occs);
+        default_allowed_species.push_back({xtal::species_name(id)});
     }
     return default_allowed_species;
 }
@@ -70,6 +718,7 @@ StructureMapper_f::StructureMapper_f(const xtal::Structure& reference,
     : reference_structure(reference),
       lattice_to_impose(reference_structure.lattice()),
       settings(input),
+      stats_collector(settings.collect_stats ? std::make_shared<StatsCollector>() : nullptr),
       factor_group(init_factor_group.empty() ? make_default_factor_group() : init_factor_group),
       allowed_species(init_allowed_species.empty() ? make_default_allowed_species() : init_allowed_species),
       mapper(
@@ -80,58 +729,466 @@ StructureMapper_f::StructureMapper_f(const xtal::Structure& reference,
           settings.options,
           settings.tol,
           settings.min_vacancy_fraction,
-          settings.max_vacancy_fraction)
+          settings.max_vacancy_fraction),
+      mapper_pool(std::make_shared<MapperPool>()),
+      report_cache(settings.cache_size > 0
+                       ? std::make_shared<LRUCache<std::string, std::vector<MappingReport>>>(settings.cache_size)
+                       : nullptr)
 {
     // Apologies for the ugly constructor we need to unpack input into
     // its individual values and do some layered inline construction
     //
     // explain more pls. what is "layered inline construction"?
+
+    // The quick checks of is_equivalent only hold if every site must keep exactly the species it has,
+    // and if both strain and displacements count towards the cost
+    const std::vector<int>& reference_species_ids = reference_structure.species_ids();
+    bool fixed_occupation = !reference_species_ids.empty() && allowed_species.size() == reference_species_ids.size();
+    for (int i = 0; fixed_occupation && i < reference_species_ids.size(); ++i)
+    {
+        const std::string& name = xtal::species_name(reference_species_ids[i]);
+        fixed_occupation = allowed_species[i].size() == 1 && allowed_species[i][0] == name && !xtal::is_vacancy(name);
+    }
+    if (fixed_occupation && settings.strain_weight > 0 && settings.strain_weight < 1)
+    {
+        reference_fingerprint = make_equivalence_fingerprint(reference_structure, settings);
+    }
+}
+
+std::shared_ptr<CASM::xtal::StrucMapper> StructureMapper_f::borrow_mapper() const
+{
+    std::unique_ptr<CASM::xtal::StrucMapper> borrowed;
+    {
+        std::lock_guard<std::mutex> lock(mapper_pool->mutex);
+        if (!mapper_pool->idle_mappers.empty())
+        {
+            borrowed = std::move(mapper_pool->idle_mappers.back());
+            mapper_pool->idle_mappers.pop_back();
+        }
+    }
+    if (!borrowed)
+    {
+        // Nobody maps with the prepared mapper itself, so it's safe to copy while other threads are mapping
+        borrowed = std::make_unique<CASM::xtal::StrucMapper>(this->mapper);
+    }
+
+    // Holding on to the pool means the mapper can go back even if this object is gone by then
+    std::shared_ptr<MapperPool> pool = this->mapper_pool;
+    return std::shared_ptr<CASM::xtal::StrucMapper>(borrowed.release(), [pool](CASM::xtal::StrucMapper* returned) {
+        std::unique_ptr<CASM::xtal::StrucMapper> returned_ptr(returned);
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->idle_mappers.push_back(std::move(returned_ptr));
+    });
 }
 
 std::vector<MappingReport> StructureMapper_f::operator()(const xtal::Structure& mappable_struc) const
 {
+    return this->map_with(*this->borrow_mapper(), mappable_struc);
+}
+
+std::vector<CompactMappingReport> StructureMapper_f::map_compact(const xtal::Structure& mappable_struc) const
+{
+    MappingStats call_stats;
+    call_stats.structures = 1;
+    Stopwatch stopwatch(this->stats_collector != nullptr);
+
+    std::set<CASM::xtal::MappingNode> casmnodes = this->k_best_nodes(mappable_struc, settings.k_best_maps);
+    call_stats.search_seconds = stopwatch.lap();
+    call_stats.nodes_found = casmnodes.size();
+
+    std::vector<CompactMappingReport> reports(casmnodes.begin(), casmnodes.end());
+    call_stats.report_seconds = stopwatch.lap();
+    if (this->stats_collector)
+    {
+        call_stats.report_bytes = report_bytes(reports);
+    }
+    this->record_stats(call_stats);
+    return reports;
+}
+
+MappingStats StructureMapper_f::stats() const
+{
+    if (!this->stats_collector)
+    {
+        return MappingStats();
+    }
+    std::lock_guard<std::mutex> lock(this->stats_collector->mutex);
+    return this->stats_collector->totals;
+}
+
+void StructureMapper_f::reset_stats()
+{
+    if (this->stats_collector)
+    {
+        std::lock_guard<std::mutex> lock(this->stats_collector->mutex);
+        this->stats_collector->totals = MappingStats();
+    }
+}
+
+void StructureMapper_f::record_stats(const MappingStats& call_stats) const
+{
+    if (this->stats_collector)
+    {
+        std::lock_guard<std::mutex> lock(this->stats_collector->mutex);
+        this->stats_collector->totals += call_stats;
+    }
+}
+
+void StructureMapper_f::save(const fs::path& prepared_path) const
+{
+    json prepared = {{"format", prepared_mapper_format},
+                     {"version", prepared_mapper_version},
+                     {"reference", structure_to_json(reference_structure)},
+                     {"input", input_to_json(settings)},
+                     {"factor_group", factor_group_to_json(factor_group)},
+                     {"allowed_species", allowed_species}};
+
+    std::ofstream prepared_stream(prepared_path);
+    if (!prepared_stream)
+    {
+        throw except::BadPath(prepared_path);
+    }
+    prepared_stream << prepared.dump();
+}
+
+StructureMapper_f StructureMapper_f::load(const fs::path& prepared_path)
+{
+    return mapper_from_json(read_prepared_json(prepared_path), MappingInput());
+}
+
+std::vector<std::vector<MappingReport>>
+StructureMapper_f::map_many(const std::vector<xtal::Structure>& mappable_strucs, int n_threads) const
+{
+    std::vector<std::vector<MappingReport>> all_reports(mappable_strucs.size());
+    // Every worker borrows a single mapper for all of its structures
+    parallel_for_with_state(
+        mappable_strucs.size(),
+        n_threads,
+        [this]() { return this->borrow_mapper(); },
+        [this, &mappable_strucs, &all_reports](const std::shared_ptr<CASM::xtal::StrucMapper>& worker_mapper,
+                                               std::size_t ix) {
+            all_reports[ix] = this->map_with(*worker_mapper, mappable_strucs[ix]);
+        });
+    return all_reports;
+}
+
+std::vector<MappingResult> StructureMapper_f::try_map_many(const std::vector<xtal::Structure>& mappable_strucs,
+                                                          int n_threads) const
+{
+    std::vector<MappingResult> all_results(mappable_strucs.size());
+    parallel_for_with_state(
+        mappable_strucs.size(),
+        n_threads,
+        [this]() { return this->borrow_mapper(); },
+        [this, &mappable_strucs, &all_results](const std::shared_ptr<CASM::xtal::StrucMapper>& worker_mapper,
+                                               std::size_t ix) {
+            try
+            {
+                all_results[ix].reports = this->map_with(*worker_mapper, mappable_strucs[ix]);
+            }
+            catch (const std::exception& e)
+            {
+                all_results[ix].error = e.what();
+                if (all_results[ix].error.empty())
+                {
+                    all_results[ix].error = "Unknown mapping error";
+                }
+            }
+        });
+    return all_results;
+}
+
+MappingEnumerator StructureMapper_f::enumerate(const xtal::Structure& mappable_struc) const
+{
+    MappingStats call_stats;
+    call_stats.structures = 1;
+    this->record_stats(call_stats);
+    return MappingEnumerator(*this, mappable_struc);
+}
+
+std::set<CASM::xtal::MappingNode> StructureMapper_f::k_best_nodes(const xtal::Structure& mappable_struc, int k) const
+{
+    return this->find_nodes(*this->borrow_mapper(), mappable_struc, k);
+}
+
+std::set<CASM::xtal::MappingNode> StructureMapper_f::find_nodes(const CASM::xtal::StrucMapper& casm_mapper,
+                                                                const xtal::Structure& mappable_struc,
+                                                                int k) const
+{
+    return this->find_nodes(
+        casm_mapper, mappable_struc, k, settings.max_cost, settings.min_cost, settings.keep_invalid_mapping_nodes);
+}
+
+std::set<CASM::xtal::MappingNode> StructureMapper_f::find_nodes(const CASM::xtal::StrucMapper& casm_mapper,
+                                                                const xtal::Structure& mappable_struc,
+                                                                int k,
+                                                                double max_cost,
+                                                                double min_cost,
+                                                                bool keep_invalid) const
+{
+    const auto& casm_struc = mappable_struc.__get<CASM::xtal::SimpleStructure>();
     if (settings.assume_ideal_structure)
     {
-        return this->ideal_map(mappable_struc);
+        return casm_mapper.map_ideal_struc(casm_struc, k, max_cost, min_cost, keep_invalid);
+    }
+
+    // The supercell is known, so skip the search over lattices and only assign the basis
+    if (settings.assume_ideal_lattice)
+    {
+        CASM::xtal::LatticeNode ideal_lattice_node =
+            make_ideal_lattice_node(reference_structure.lattice(), mappable_struc, settings.tol);
+        return casm_mapper.map_deformed_struc_impose_lattice_node(
+            casm_struc, ideal_lattice_node, k, max_cost, min_cost, keep_invalid);
+    }
+
+    // Only the orientations of the reference lattice are searched, not its supercells
+    if (settings.impose_reference_lattice)
+    {
+        return casm_mapper.map_deformed_struc_impose_lattice(
+            casm_struc, lattice_to_impose.__get(), k, max_cost, min_cost, keep_invalid);
     }
 
-    return this->map(mappable_struc);
+    return casm_mapper.map_deformed_struc(casm_struc, k, max_cost, min_cost, keep_invalid);
+}
+
+MappingEnumerator::MappingEnumerator(const StructureMapper_f& mapper, const xtal::Structure& mappable_struc)
+    : mapper(&mapper), mappable_struc(mappable_struc), next_node_ix(0), is_exhausted(false)
+{
 }
 
-std::vector<MappingReport> StructureMapper_f::map(const xtal::Structure& mappable_struc) const
+std::optional<MappingReport> MappingEnumerator::next()
 {
+    if (next_node_ix == found_nodes.size() && !is_exhausted)
+    {
+        // The nodes come back sorted by cost, so the ones that were already handed out lead the new batch.
+        // Seeding the search with the last cost wouldn't skip them: CASM keeps every node below min_cost
+        // on top of the k best, it doesn't drop them.
+        int batch_size = std::max<int>(1, 2 * found_nodes.size());
+        Stopwatch stopwatch(mapper->stats_collector != nullptr);
+        std::set<CASM::xtal::MappingNode> nodes = mapper->k_best_nodes(mappable_struc, batch_size);
+        MappingStats batch_stats;
+        batch_stats.search_seconds = stopwatch.lap();
+        batch_stats.nodes_found = nodes.size();
+        mapper->record_stats(batch_stats);
 
-    auto casmnodes = mapper.map_deformed_struc(mappable_struc.__get<CASM::xtal::SimpleStructure>(),
-                                               settings.k_best_maps,
-                                               settings.max_cost,
-                                               settings.min_cost,
-                                               settings.keep_invalid_mapping_nodes);
-    std::vector<MappingReport> casted_set(casmnodes.begin(), casmnodes.end());
-    return casted_set;
+        is_exhausted = nodes.size() < batch_size;
+        found_nodes.assign(nodes.begin(), nodes.end());
+    }
+
+    if (next_node_ix >= found_nodes.size())
+    {
+        return std::nullopt;
+    }
+
+    Stopwatch stopwatch(mapper->stats_collector != nullptr);
+    MappingReport report(found_nodes[next_node_ix++]);
+    MappingStats report_stats;
+    report_stats.report_seconds = stopwatch.lap();
+    if (mapper->stats_collector)
+    {
+        report_stats.report_bytes = report_bytes(std::vector<MappingReport>{report});
+    }
+    mapper->record_stats(report_stats);
+    return report;
 }
 
-std::vector<MappingReport> StructureMapper_f::ideal_map(const xtal::Structure& mappable_struc) const
+bool StructureMapper_f::is_equivalent(const xtal::Structure& mappable_struc) const
 {
-    auto casmnodes = mapper.map_ideal_struc(mappable_struc.__get<CASM::xtal::SimpleStructure>(),
-                                            settings.k_best_maps,
-                                            settings.max_cost,
-                                            settings.min_cost,
-                                            settings.keep_invalid_mapping_nodes);
-    std::vector<MappingReport> casted_set(casmnodes.begin(), casmnodes.end());
-    return casted_set;
+    if (!this->reference_fingerprint)
+    {
+        return this->has_equivalent_map(mappable_struc);
+    }
+
+    // Don't bother making a fingerprint if the composition already gives it away
+    if (this->is_obviously_not_equivalent(mappable_struc))
+    {
+        MappingStats call_stats;
+        call_stats.structures = 1;
+        call_stats.ruled_out_early = 1;
+        this->record_stats(call_stats);
+        return false;
+    }
+    return this->is_equivalent(mappable_struc, make_equivalence_fingerprint(mappable_struc, settings));
+}
+
+bool StructureMapper_f::is_equivalent(const xtal::Structure& mappable_struc,
+                                      const xtal::StructureFingerprint& mappable_fingerprint) const
+{
+    if (this->reference_fingerprint &&
+        (this->is_obviously_not_equivalent(mappable_struc) ||
+         !xtal::could_be_equivalent(loosened_fingerprint(*this->reference_fingerprint, mappable_fingerprint.tol),
+                                    mappable_fingerprint)))
+    {
+        MappingStats call_stats;
+        call_stats.structures = 1;
+        call_stats.ruled_out_early = 1;
+        this->record_stats(call_stats);
+        return false;
+    }
+    return this->has_equivalent_map(mappable_struc);
+}
+
+bool StructureMapper_f::is_obviously_not_equivalent(const xtal::Structure& mappable_struc) const
+{
+    // The mappable structure may be a superstructure of the reference, so it needs the same
+    // species in the same proportions
+    const std::vector<int>& reference_species_ids = reference_structure.species_ids();
+    const std::vector<int>& mappable_species_ids = mappable_struc.species_ids();
+    if (mappable_species_ids.size() % reference_species_ids.size() != 0)
+    {
+        return true;
+    }
+
+    std::unordered_map<int, long> species_balance;
+    for (int id : reference_species_ids)
+    {
+        species_balance[id] += mappable_species_ids.size();
+    }
+    for (int id : mappable_species_ids)
+    {
+        species_balance[id] -= reference_species_ids.size();
+    }
+    // The volume says nothing, since neither the lattice cost nor the basis cost changes when everything
+    // gets scaled by the same amount
+    for (const auto& id_and_balance : species_balance)
+    {
+        if (id_and_balance.second != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StructureMapper_f::has_equivalent_map(const xtal::Structure& mappable_struc) const
+{
+    // Asking for the single best map, and pruning anything over the threshold, lets the search
+    // stop as soon as it finds a map that's good enough
+    double max_cost = equivalence_cost(settings);
+    MappingStats call_stats;
+    call_stats.structures = 1;
+
+    // A lattice that isn't a supercell of the reference is an error when mapping, but here it only means that
+    // the structure isn't equivalent
+    if (settings.assume_ideal_lattice && !settings.assume_ideal_structure &&
+        !find_ideal_lattice_node(reference_structure.lattice(), mappable_struc, settings.tol))
+    {
+        call_stats.ruled_out_early = 1;
+        this->record_stats(call_stats);
+        return false;
+    }
+
+    std::shared_ptr<CASM::xtal::StrucMapper> casm_mapper = this->borrow_mapper();
+    Stopwatch stopwatch(this->stats_collector != nullptr);
+    auto casmnodes = this->find_nodes(*casm_mapper, mappable_struc, 1, max_cost, -settings.tol, false);
+    call_stats.search_seconds = stopwatch.lap();
+    call_stats.nodes_found = casmnodes.size();
+    this->record_stats(call_stats);
+
+    return std::any_of(casmnodes.begin(), casmnodes.end(), [max_cost](const CASM::xtal::MappingNode& node) {
+        return node.is_valid && node.cost <= max_cost;
+    });
+}
+
+std::string StructureMapper_f::make_cache_key(const xtal::Structure& mappable_struc) const
+{
+    // The key is the structure itself, byte for byte, so a hit is always for the very same structure.
+    // Anything that moved, however little, maps again and gets reports of its own.
+    const Eigen::Matrix3d& lat_mat = mappable_struc.lattice().column_vector_matrix();
+    const Eigen::Matrix3Xd& cart_coords = mappable_struc.cart_coords();
+    const std::vector<int>& species_ids = mappable_struc.species_ids();
+
+    std::string key;
+    key.reserve(9 * sizeof(double) + cart_coords.size() * sizeof(double) + species_ids.size() * sizeof(int));
+    key.append(reinterpret_cast<const char*>(lat_mat.data()), 9 * sizeof(double));
+    key.append(reinterpret_cast<const char*>(cart_coords.data()), cart_coords.size() * sizeof(double));
+    key.append(reinterpret_cast<const char*>(species_ids.data()), species_ids.size() * sizeof(int));
+    return key;
+}
+
+std::vector<MappingReport> StructureMapper_f::map_with(const CASM::xtal::StrucMapper& casm_mapper,
+                                                       const xtal::Structure& mappable_struc) const
+{
+    MappingStats call_stats;
+    call_stats.structures = 1;
+    Stopwatch stopwatch(this->stats_collector != nullptr);
+
+    std::string cache_key;
+    if (this->report_cache)
+    {
+        cache_key = this->make_cache_key(mappable_struc);
+        std::optional<std::vector<MappingReport>> cached_reports = this->report_cache->get(cache_key);
+        call_stats.cache_seconds = stopwatch.lap();
+        if (cached_reports)
+        {
+            call_stats.cache_hits = 1;
+            this->record_stats(call_stats);
+            return *cached_reports;
+        }
+    }
+
+    std::set<CASM::xtal::MappingNode> casmnodes = this->find_nodes(casm_mapper, mappable_struc, settings.k_best_maps);
+    call_stats.search_seconds = stopwatch.lap();
+    call_stats.nodes_found = casmnodes.size();
+
+    std::vector<MappingReport> reports(casmnodes.begin(), casmnodes.end());
+    call_stats.report_seconds = stopwatch.lap();
+    if (this->stats_collector)
+    {
+        call_stats.report_bytes = report_bytes(reports);
+    }
+
+    if (this->report_cache)
+    {
+        this->report_cache->put(cache_key, reports);
+        call_stats.cache_seconds += stopwatch.lap();
+    }
+    this->record_stats(call_stats);
+    return reports;
 }
 
 //***********************************************************************************//
 
 std::vector<mapping::MappingReport> map_structure(const xtal::Structure& map_reference_struc,
-                                                  const xtal::Structure& mappable_struc)
+                                                  const xtal::Structure& mappable_struc,
+                                                  const fs::path& cache_dir)
 {
     mapping::MappingInput input;
     input.use_crystal_symmetry = true;
+    if (!cache_dir.empty())
+    {
+        return load_or_prepare_mapper(cache_dir, map_reference_struc, input)(mappable_struc);
+    }
     mapping::StructureMapper_f mapper(map_reference_struc, input);
     return mapper(mappable_struc);
 }
 
+StructureEquals_f::StructureEquals_f(const MappingInput& input) : settings(input) {}
+
+bool StructureEquals_f::operator()(const xtal::Structure& reference, const xtal::Structure& other) const
+{
+    return StructureMapper_f(reference, settings).is_equivalent(other);
+}
+
+xtal::StructureFingerprint make_equivalence_fingerprint(const xtal::Structure& struc, const MappingInput& input)
+{
+    if (input.strain_weight >= 1)
+    {
+        throw except::UserInputMangle("Displacements don't count towards the cost when the strain weight is 1");
+    }
+    if (input.strain_weight <= 0)
+    {
+        throw except::UserInputMangle("Strain doesn't count towards the cost when the strain weight is 0");
+    }
+
+    // Scaling to the same volume per atom makes the fingerprint blind to the volume, just like the cost
+    int n_atoms = struc.species_ids().size();
+    double length_unit = std::cbrt(std::abs(struc.lattice().volume()) / std::max(n_atoms, 1));
+    xtal::Structure unit_volume_struc =
+        xtal::apply_deformation(struc, Eigen::Matrix3d(Eigen::Matrix3d::Identity() / length_unit));
+    return xtal::fingerprint(unit_volume_struc, equivalent_distance_bound(n_atoms, input, length_unit));
+}
+
 std::pair<double, double> structure_score(const mapping::MappingReport& mapping_data)
 {
     double lattice_score = CASM::xtal::StrainCostCalculator::isotropic_strain_cost(mapping_data.stretch);
@@ -143,32 +1200,29 @@ mapping::MappingReport symmetry_preserving_mapping_report(const mapping::Mapping
                                                           const std::vector<sym::CartOp>& group_as_operations,
                                                           const std::vector<sym::PermRep>& group_as_permutations)
 {
-
-    const auto disp_matrix = mapping_data.displacement;
-    auto symmetry_preserving_displacement = disp_matrix;
-    auto symmetry_preserving_stretch = mapping_data.stretch;
-    symmetry_preserving_displacement.setZero();
-    symmetry_preserving_stretch.setZero();
-    for (int i = 0; i < group_as_operations.size(); ++i)
-    {
-        auto transformed_disp = group_as_operations[i].matrix * disp_matrix;
-        Eigen::MatrixXd transformed_and_permuted_disp = transformed_disp;
-        transformed_and_permuted_disp.setZero();
-        int ind = 0;
-        for (const auto& j : group_as_permutations[i])
-        {
-            transformed_and_permuted_disp.col(j) += transformed_disp.col(ind);
-            ind++;
-        }
-        symmetry_preserving_displacement += transformed_and_permuted_disp / group_as_operations.size();
-        Eigen::MatrixXd transformed_stretch =
-            group_as_operations[i].matrix.transpose() * mapping_data.stretch * group_as_operations[i].matrix;
-        symmetry_preserving_stretch += transformed_stretch / group_as_operations.size();
-    }
+    SymmetryPreservingProjection projection(group_as_operations, group_as_permutations);
+    Eigen::MatrixXd transformed_stretch;
     auto new_report = mapping_data;
-    new_report.stretch = symmetry_preserving_stretch;
-    new_report.displacement = symmetry_preserving_displacement;
+    projection.project(mapping_data, &new_report, &transformed_stretch);
     return new_report;
 }
+
+std::vector<mapping::MappingReport>
+symmetry_preserving_mapping_reports(const std::vector<mapping::MappingReport>& all_mapping_data,
+                                    const std::vector<sym::CartOp>& group_as_operations,
+                                    const std::vector<sym::PermRep>& group_as_permutations,
+                                    int n_threads)
+{
+    SymmetryPreservingProjection projection(group_as_operations, group_as_permutations);
+    auto new_reports = all_mapping_data;
+    parallel_for_with_state(
+        all_mapping_data.size(),
+        n_threads,
+        []() { return Eigen::MatrixXd(); },
+        [&](Eigen::MatrixXd& transformed_stretch, std::size_t ix) {
+            projection.project(all_mapping_data[ix], &new_reports[ix], &transformed_stretch);
+        });
+    return new_reports;
+}
 } // namespace mapping
 } // namespace casmutils
@@ -4,6 +4,7 @@
 #include <casmutils/xtal/coordinate.hpp>
 #include <casmutils/xtal/lattice.hpp>
 #include <casmutils/xtal/structure.hpp>
+#include <algorithm>
 #include <cassert>
 #include <utility>
 
@@ -49,20 +50,28 @@ xtal::Structure make_cleaved_structure(const xtal::Structure& slab, double cleav
 std::pair<std::vector<Eigen::Vector3d>, std::vector<ShiftRecord>>
 make_uniform_in_plane_shift_vectors(const xtal::Lattice& slab_lattice, int a_max, int b_max)
 {
-    std::vector<Eigen::Vector3d> shifts;
+    Eigen::Matrix3Xd frac_coords(3, a_max * b_max);
     std::vector<ShiftRecord> records;
+    records.reserve(a_max * b_max);
     int ix = 0;
     for (int a = 0; a < a_max; ++a)
     {
         for (int b = 0; b < b_max; ++b)
         {
-            Eigen::Vector3d frac_coord(static_cast<double>(a) / a_max, static_cast<double>(b) / b_max, 0);
-            shifts.emplace_back(xtal::fractional_to_cartesian(frac_coord, slab_lattice));
-
+            frac_coords.col(ix) << static_cast<double>(a) / a_max, static_cast<double>(b) / b_max, 0;
             records.emplace_back(a, b, ix);
             ++ix;
         }
     }
+
+    // Convert the whole grid at once
+    Eigen::Matrix3Xd cart_coords = xtal::fractional_to_cartesian_batch(frac_coords, slab_lattice);
+    std::vector<Eigen::Vector3d> shifts;
+    shifts.reserve(cart_coords.cols());
+    for (Eigen::Index i = 0; i < cart_coords.cols(); ++i)
+    {
+        shifts.emplace_back(cart_coords.col(i));
+    }
     return std::make_pair(std::move(shifts), std::move(records));
 }
 
@@ -108,23 +117,54 @@ mapping::MappingInput make_shifted_structures_categorization_map_strategy()
     return map_strategy;
 }
 
+namespace
+{
+/// Structures that were all found to be equivalent to the first one
+struct EquivalenceClass
+{
+    mapping::StructureMapper_f map_to_representative;
+    std::vector<std::size_t> members;
+};
+} // namespace
+
 std::vector<std::vector<std::size_t>>
 categorize_equivalently_shifted_structures(const std::vector<xtal::Structure>& shifted_structures)
 {
-    std::vector<std::vector<std::size_t>> index_map;
     mapping::MappingInput map_strategy = make_shifted_structures_categorization_map_strategy();
-    for (const auto shifted_structure : shifted_structures)
+
+    // Equivalence is transitive, so each structure only needs to be mapped onto the first member of each
+    // class found so far, rather than onto every other structure. Each class keeps its mapper, so the
+    // factor group is only found once per class. Comparing fingerprints can rule out a class without
+    // any mapping, but how many it rules out depends on the structures. The fingerprint of each
+    // structure is only made once.
+    std::vector<EquivalenceClass> classes;
+    std::vector<std::size_t> class_indexes;
+    class_indexes.reserve(shifted_structures.size());
+    for (std::size_t s_ix = 0; s_ix < shifted_structures.size(); ++s_ix)
     {
-        mapping::StructureMapper_f map_to_shifted(shifted_structure, map_strategy);
-        index_map.push_back({});
-        for (int s_ix = 0; s_ix < shifted_structures.size(); ++s_ix)
+        const xtal::Structure& shifted_structure = shifted_structures[s_ix];
+        xtal::StructureFingerprint shifted_fingerprint =
+            mapping::make_equivalence_fingerprint(shifted_structure, map_strategy);
+
+        auto maps_onto_class = [&](const EquivalenceClass& candidate) {
+            return candidate.map_to_representative.is_equivalent(shifted_structure, shifted_fingerprint);
+        };
+        auto class_it = std::find_if(classes.begin(), classes.end(), maps_onto_class);
+        if (class_it == classes.end())
         {
-            auto results = map_to_shifted(shifted_structures[s_ix]);
-            if (results.size() > 0)
-            {
-                index_map.back().emplace_back(s_ix);
-            }
+            classes.push_back({mapping::StructureMapper_f(shifted_structure, map_strategy), {}});
+            class_it = std::prev(classes.end());
         }
+
+        class_it->members.push_back(s_ix);
+        class_indexes.push_back(std::distance(classes.begin(), class_it));
+    }
+
+    std::vector<std::vector<std::size_t>> index_map;
+    index_map.reserve(shifted_structures.size());
+    for (std::size_t class_ix : class_indexes)
+    {
+        index_map.push_back(classes[class_ix].members);
     }
     return index_map;
 }
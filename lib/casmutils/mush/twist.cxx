@@ -84,7 +84,7 @@ xtal::Lattice make_twisted_lattice(const xtal::Lattice& lat, double degrees)
 std::pair<Eigen::Matrix3l, Eigen::Matrix3d> approximate_integer_transformation(const xtal::Lattice& L,
                                                                                const xtal::Lattice& M)
 {
-    Eigen::Matrix3d Td = L.column_vector_matrix().inverse() * M.column_vector_matrix();
+    Eigen::Matrix3d Td = L.inverse_column_vector_matrix() * M.column_vector_matrix();
 
     Eigen::Matrix3l T = CASM::lround(Td);
     Eigen::Matrix3d E = Td - T.cast<double>();
@@ -225,8 +225,8 @@ MoireApproximant::MoireApproximant(const xtal::Lattice& moire_lat,
     this->approximate_moire_lattice = xtal::Lattice(S_bar);
 
     // Determine the strain involved to make things purrfect
-    Eigen::Matrix3d aligned_F = S_bar * aligned_S.column_vector_matrix().inverse();
-    Eigen::Matrix3d rotated_F = S_bar * rotated_S.column_vector_matrix().inverse();
+    Eigen::Matrix3d aligned_F = S_bar * aligned_S.inverse_column_vector_matrix();
+    Eigen::Matrix3d rotated_F = S_bar * rotated_S.inverse_column_vector_matrix();
     approximation_deformations[LATTICE::ALIGNED] = aligned_F;
     approximation_deformations[LATTICE::ROTATED] = rotated_F;
 
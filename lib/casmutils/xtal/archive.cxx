@@ -0,0 +1,433 @@
+#include <casmutils/exceptions.hpp>
+#include <casmutils/xtal/archive.hpp>
+#include <casmutils/xtal/species.hpp>
+#include <casmutils/xtal/structure_tools.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr char header_magic[8] = {'C', 'U', 'S', 'T', 'R', 'U', 'C', 'T'};
+constexpr char footer_magic[8] = {'C', 'U', 'S', 'T', 'R', 'I', 'D', 'X'};
+constexpr std::uint32_t archive_version = 1;
+/// Reads back as something else if the archive was written with a different byte order
+constexpr std::uint32_t byte_order_mark = 0x01020304;
+constexpr std::uint64_t header_size = sizeof(header_magic) + 2 * sizeof(std::uint32_t);
+constexpr std::uint64_t footer_size = sizeof(std::uint64_t) + sizeof(footer_magic);
+
+template <typename ValueType> void write_value(std::ostream& stream, const ValueType& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(ValueType));
+}
+
+void write_string(std::ostream& stream, const std::string& value)
+{
+    write_value<std::uint64_t>(stream, value.size());
+    stream.write(value.data(), value.size());
+}
+
+/// Creates an empty file with a unique name next to the archive, so that writers of the same archive
+/// (or of archives with similar names) never share their copy. Being in the same directory means the
+/// rename that replaces the archive stays within one file system.
+casmutils::fs::path make_staging_file(const casmutils::fs::path& archive_path)
+{
+    std::string name_template = archive_path.string() + ".XXXXXX";
+    int file_descriptor = ::mkstemp(name_template.data());
+    if (file_descriptor < 0)
+    {
+        throw except::BadPath(archive_path);
+    }
+    // mkstemp only lets the owner read the file, which would carry over to the archive
+    ::fchmod(file_descriptor, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    ::close(file_descriptor);
+    return name_template;
+}
+
+/// Walks through the bytes of the mapped archive, checking that every read stays within the file
+class ArchiveCursor
+{
+public:
+    ArchiveCursor(const char* data, std::uint64_t size, std::uint64_t offset) : data(data), size(size), offset(offset)
+    {
+    }
+
+    template <typename ValueType> ValueType read_value()
+    {
+        ValueType value;
+        std::memcpy(&value, this->_advance(sizeof(ValueType)), sizeof(ValueType));
+        return value;
+    }
+
+    std::string read_string()
+    {
+        std::uint64_t length = this->read_value<std::uint64_t>();
+        return std::string(this->_advance(length), length);
+    }
+
+private:
+    const char* data;
+    std::uint64_t size;
+    std::uint64_t offset;
+
+    const char* _advance(std::uint64_t bytes)
+    {
+        if (bytes > this->size || this->offset > this->size - bytes)
+        {
+            throw except::BadArchive("the file ends in the middle of the index");
+        }
+        const char* position = this->data + this->offset;
+        this->offset += bytes;
+        return position;
+    }
+};
+} // namespace
+
+namespace casmutils
+{
+namespace xtal
+{
+StructureArchiveWriter::StructureArchiveWriter(const fs::path& archive_path) : archive_path(archive_path)
+{
+    if (fs::exists(archive_path))
+    {
+        // Pick up the tables of the existing archive. New structures are written over the tables
+        // of a copy, so the archive itself stays readable until the copy replaces it.
+        StructureArchiveReader existing(archive_path);
+        this->species_names = existing.species_names();
+        for (std::uint64_t ix = 0; ix < this->species_names.size(); ++ix)
+        {
+            this->species_index_of_id[species_id(this->species_names[ix])] = ix;
+        }
+        this->lattices = existing.lattices();
+        for (std::uint64_t ix = 0; ix < this->lattices.size(); ++ix)
+        {
+            this->lattice_index_of_values.emplace(
+                std::vector<double>(this->lattices[ix].data(), this->lattices[ix].data() + 9), ix);
+        }
+        this->records = existing.records();
+        for (std::size_t ix = 0; ix < this->records.size(); ++ix)
+        {
+            this->record_index_of_key[this->records[ix].key] = ix;
+        }
+        this->write_offset = existing.tables_offset();
+
+        this->staging_path = make_staging_file(archive_path);
+        fs::copy_file(archive_path, this->staging_path, fs::copy_options::overwrite_existing);
+        fs::resize_file(this->staging_path, this->write_offset);
+        this->archive_stream.open(this->staging_path, std::ios::binary | std::ios::in | std::ios::out);
+        this->archive_stream.seekp(this->write_offset);
+    }
+    else
+    {
+        this->staging_path = make_staging_file(archive_path);
+        this->archive_stream.open(this->staging_path, std::ios::binary | std::ios::out);
+        this->archive_stream.write(header_magic, sizeof(header_magic));
+        write_value(this->archive_stream, archive_version);
+        write_value(this->archive_stream, byte_order_mark);
+        this->write_offset = header_size;
+    }
+    this->_check_stream();
+}
+
+StructureArchiveWriter::~StructureArchiveWriter()
+{
+    // Only an explicit close() replaces the archive. A writer that goes out of scope without one, e.g. while
+    // unwinding from an exception halfway through a batch, leaves the archive as it was.
+    if (this->archive_stream.is_open())
+    {
+        this->archive_stream.close();
+        std::error_code ignored;
+        fs::remove(this->staging_path, ignored);
+    }
+}
+
+void StructureArchiveWriter::_check_stream()
+{
+    if (!this->archive_stream)
+    {
+        this->archive_stream.close();
+        fs::remove(this->staging_path);
+        throw except::BadPath(this->staging_path);
+    }
+}
+
+std::uint64_t StructureArchiveWriter::_lattice_index(const Lattice& lat)
+{
+    const Eigen::Matrix3d& lat_mat = lat.column_vector_matrix();
+    auto inserted = this->lattice_index_of_values.emplace(std::vector<double>(lat_mat.data(), lat_mat.data() + 9),
+                                                          this->lattices.size());
+    if (inserted.second)
+    {
+        this->lattices.push_back(lat_mat);
+    }
+    return inserted.first->second;
+}
+
+void StructureArchiveWriter::append(const std::string& key, const Structure& struc, const ArchiveMetadata& metadata)
+{
+    if (!this->archive_stream.is_open())
+    {
+        throw std::runtime_error("Cannot append to a structure archive that has already been closed");
+    }
+    if (this->record_index_of_key.count(key))
+    {
+        throw except::UserInputMangle("The key " + key + " is already in the structure archive");
+    }
+
+    const Eigen::Matrix3Xd& cart_coords = struc.cart_coords();
+    std::vector<std::uint32_t> species_indices;
+    species_indices.reserve(struc.species_ids().size());
+    for (int id : struc.species_ids())
+    {
+        auto inserted = this->species_index_of_id.emplace(id, this->species_names.size());
+        if (inserted.second)
+        {
+            this->species_names.push_back(species_name(id));
+        }
+        species_indices.push_back(inserted.first->second);
+    }
+
+    // Coordinates go in exactly as they're stored, one column per site. Blocks are padded to keep
+    // the coordinates of every structure aligned.
+    std::uint64_t coord_bytes = cart_coords.size() * sizeof(double);
+    std::uint64_t species_bytes = species_indices.size() * sizeof(std::uint32_t);
+    std::uint64_t padding = (8 - species_bytes % 8) % 8;
+    this->archive_stream.write(reinterpret_cast<const char*>(cart_coords.data()), coord_bytes);
+    this->archive_stream.write(reinterpret_cast<const char*>(species_indices.data()), species_bytes);
+    const char zeros[8] = {};
+    this->archive_stream.write(zeros, padding);
+    this->_check_stream();
+
+    this->record_index_of_key[key] = this->records.size();
+    this->records.push_back(
+        {key, this->write_offset, species_indices.size(), this->_lattice_index(struc.lattice()), metadata});
+    this->write_offset += coord_bytes + species_bytes + padding;
+    return;
+}
+
+void StructureArchiveWriter::close()
+{
+    if (!this->archive_stream.is_open())
+    {
+        return;
+    }
+
+    std::ostream& stream = this->archive_stream;
+    write_value<std::uint64_t>(stream, this->species_names.size());
+    for (const std::string& name : this->species_names)
+    {
+        write_string(stream, name);
+    }
+
+    write_value<std::uint64_t>(stream, this->lattices.size());
+    for (const Eigen::Matrix3d& lat_mat : this->lattices)
+    {
+        stream.write(reinterpret_cast<const char*>(lat_mat.data()), 9 * sizeof(double));
+    }
+
+    write_value<std::uint64_t>(stream, this->records.size());
+    for (const ArchiveRecord& record : this->records)
+    {
+        write_string(stream, record.key);
+        write_value(stream, record.offset);
+        write_value(stream, record.site_count);
+        write_value(stream, record.lattice_index);
+        write_value<std::uint64_t>(stream, record.metadata.size());
+        for (const auto& [name, value] : record.metadata)
+        {
+            write_string(stream, name);
+            write_value(stream, value);
+        }
+    }
+
+    write_value(stream, this->write_offset);
+    stream.write(footer_magic, sizeof(footer_magic));
+    this->archive_stream.flush();
+    this->_check_stream();
+    this->archive_stream.close();
+    this->_check_stream();
+
+    std::error_code rename_error;
+    fs::rename(this->staging_path, this->archive_path, rename_error);
+    if (rename_error)
+    {
+        fs::remove(this->staging_path, rename_error);
+        throw except::BadPath(this->archive_path);
+    }
+    return;
+}
+
+StructureArchiveReader::StructureArchiveReader(const fs::path& archive_path)
+{
+    int file_descriptor = ::open(archive_path.c_str(), O_RDONLY);
+    if (file_descriptor < 0)
+    {
+        throw except::BadPath(archive_path);
+    }
+    struct stat file_status;
+    if (::fstat(file_descriptor, &file_status) != 0)
+    {
+        ::close(file_descriptor);
+        throw except::BadPath(archive_path);
+    }
+    this->mapped_size = file_status.st_size;
+    if (this->mapped_size < header_size + footer_size)
+    {
+        ::close(file_descriptor);
+        throw except::BadArchive("the file is too small to be an archive");
+    }
+
+    void* mapped = ::mmap(nullptr, this->mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    ::close(file_descriptor);
+    if (mapped == MAP_FAILED)
+    {
+        throw except::BadPath(archive_path);
+    }
+    std::size_t size = this->mapped_size;
+    this->mapped_data =
+        std::shared_ptr<const char>(static_cast<const char*>(mapped), [size](const char* data) {
+            ::munmap(const_cast<char*>(data), size);
+        });
+
+    const char* data = this->mapped_data.get();
+    ArchiveCursor header(data, this->mapped_size, sizeof(header_magic));
+    if (std::memcmp(data, header_magic, sizeof(header_magic)) != 0 ||
+        header.read_value<std::uint32_t>() != archive_version)
+    {
+        throw except::BadArchive("unrecognized header in " + archive_path.string());
+    }
+    if (header.read_value<std::uint32_t>() != byte_order_mark)
+    {
+        throw except::BadArchive("the archive was written with a different byte order");
+    }
+
+    const char* footer = data + this->mapped_size - footer_size;
+    if (std::memcmp(footer + sizeof(std::uint64_t), footer_magic, sizeof(footer_magic)) != 0)
+    {
+        throw except::BadArchive("the index is missing, the writer was probably never closed");
+    }
+    std::memcpy(&this->archive_tables_offset, footer, sizeof(std::uint64_t));
+
+    ArchiveCursor tables(data, this->mapped_size - footer_size, this->archive_tables_offset);
+    std::uint64_t species_count = tables.read_value<std::uint64_t>();
+    for (std::uint64_t ix = 0; ix < species_count; ++ix)
+    {
+        this->archive_species_names.push_back(tables.read_string());
+        this->species_ids.push_back(species_id(this->archive_species_names.back()));
+    }
+
+    std::uint64_t lattice_count = tables.read_value<std::uint64_t>();
+    this->archive_lattices.resize(lattice_count);
+    for (Eigen::Matrix3d& lat_mat : this->archive_lattices)
+    {
+        for (int ix = 0; ix < 9; ++ix)
+        {
+            lat_mat.data()[ix] = tables.read_value<double>();
+        }
+    }
+
+    std::uint64_t record_count = tables.read_value<std::uint64_t>();
+    this->archive_records.reserve(record_count);
+    for (std::uint64_t ix = 0; ix < record_count; ++ix)
+    {
+        ArchiveRecord record;
+        record.key = tables.read_string();
+        record.offset = tables.read_value<std::uint64_t>();
+        record.site_count = tables.read_value<std::uint64_t>();
+        record.lattice_index = tables.read_value<std::uint64_t>();
+        std::uint64_t metadata_count = tables.read_value<std::uint64_t>();
+        for (std::uint64_t m = 0; m < metadata_count; ++m)
+        {
+            std::string name = tables.read_string();
+            record.metadata[name] = tables.read_value<double>();
+        }
+
+        // Dividing instead of multiplying, so that a corrupt site count can't overflow past the check
+        constexpr std::uint64_t bytes_per_site = 3 * sizeof(double) + sizeof(std::uint32_t);
+        if (record.lattice_index >= lattice_count || record.offset > this->archive_tables_offset ||
+            record.site_count > (this->archive_tables_offset - record.offset) / bytes_per_site)
+        {
+            throw except::BadArchive("the index entry for " + record.key + " points outside the archive");
+        }
+
+        this->record_index_of_key[record.key] = this->archive_records.size();
+        this->archive_records.push_back(std::move(record));
+    }
+}
+
+std::vector<std::string> StructureArchiveReader::keys() const
+{
+    std::vector<std::string> all_keys;
+    all_keys.reserve(this->archive_records.size());
+    for (const ArchiveRecord& record : this->archive_records)
+    {
+        all_keys.push_back(record.key);
+    }
+    return all_keys;
+}
+
+bool StructureArchiveReader::contains(const std::string& key) const { return this->record_index_of_key.count(key); }
+
+const ArchiveRecord& StructureArchiveReader::_record(const std::string& key) const
+{
+    auto found = this->record_index_of_key.find(key);
+    if (found == this->record_index_of_key.end())
+    {
+        throw std::out_of_range("There is no structure with the key " + key + " in the archive");
+    }
+    return this->archive_records[found->second];
+}
+
+Structure StructureArchiveReader::structure(const std::string& key) const
+{
+    return this->_read_structure(this->_record(key));
+}
+
+Structure StructureArchiveReader::structure(std::size_t index) const
+{
+    if (index >= this->archive_records.size())
+    {
+        throw std::out_of_range("There is no structure at index " + std::to_string(index) + " of the archive");
+    }
+    return this->_read_structure(this->archive_records[index]);
+}
+
+Structure StructureArchiveReader::_read_structure(const ArchiveRecord& record) const
+{
+    const char* block = this->mapped_data.get() + record.offset;
+    Eigen::Matrix3Xd cart_coords(3, record.site_count);
+    std::memcpy(cart_coords.data(), block, cart_coords.size() * sizeof(double));
+    block += cart_coords.size() * sizeof(double);
+
+    std::vector<int> struc_species_ids(record.site_count);
+    for (std::uint64_t ix = 0; ix < record.site_count; ++ix)
+    {
+        std::uint32_t species_index;
+        std::memcpy(&species_index, block + ix * sizeof(std::uint32_t), sizeof(std::uint32_t));
+        if (species_index >= this->species_ids.size())
+        {
+            throw except::BadArchive("the structure " + record.key + " refers to a species that doesn't exist");
+        }
+        struc_species_ids[ix] = this->species_ids[species_index];
+    }
+
+    return Structure(Lattice(this->archive_lattices[record.lattice_index]), cart_coords, struc_species_ids);
+}
+
+const ArchiveMetadata& StructureArchiveReader::metadata(const std::string& key) const
+{
+    return this->_record(key).metadata;
+}
+
+void StructureArchiveReader::export_poscar(const std::string& key, const fs::path& poscar_path) const
+{
+    write_poscar(this->structure(key), poscar_path);
+    return;
+}
+} // namespace xtal
+} // namespace casmutils
@@ -9,12 +9,12 @@ namespace xtal
 {
 Eigen::Vector3d fractional_to_cartesian(const Eigen::Vector3d& fractional_coordinates, const Lattice& lat)
 {
-    return CASM::xtal::Coordinate(fractional_coordinates, lat.__get(), CASM::FRAC).cart();
+    return lat.column_vector_matrix() * fractional_coordinates;
 }
 
 Eigen::Vector3d cartesian_to_fractional(const Eigen::Vector3d& cartesian_coord, const Lattice& lat)
 {
-    return CASM::xtal::Coordinate(cartesian_coord, lat.__get(), CASM::CART).frac();
+    return lat.inverse_column_vector_matrix() * cartesian_coord;
 }
 
 Eigen::Vector3d bring_within_lattice(const Eigen::Vector3d& cartesian_coord, const Lattice& lat)
@@ -31,6 +31,46 @@ Eigen::Vector3d bring_within_wigner_seitz(const Eigen::Vector3d& cartesian_coord
     return casm_coord.cart();
 }
 
+Eigen::Matrix3Xd fractional_to_cartesian_batch(const Eigen::Ref<const Eigen::Matrix3Xd>& fractional_coordinates,
+                                               const Lattice& lat)
+{
+    return lat.column_vector_matrix() * fractional_coordinates;
+}
+
+Eigen::Matrix3Xd cartesian_to_fractional_batch(const Eigen::Ref<const Eigen::Matrix3Xd>& cartesian_coordinates,
+                                               const Lattice& lat)
+{
+    return lat.inverse_column_vector_matrix() * cartesian_coordinates;
+}
+
+Eigen::Matrix3Xd bring_within_lattice_batch(const Eigen::Ref<const Eigen::Matrix3Xd>& cartesian_coordinates,
+                                            const Lattice& lat)
+{
+    // Same tolerance CASM::xtal::Coordinate::within uses, so that coordinates sitting right
+    // on the upper boundary get wrapped to zero the same way
+    const double within_tol = 1e-6;
+    Eigen::Matrix3Xd frac_coordinates = cartesian_to_fractional_batch(cartesian_coordinates, lat);
+    Eigen::Matrix3Xd lattice_translations = (frac_coordinates.array() + within_tol).floor().matrix();
+    // Subtracting translations rather than going back from fractional keeps coordinates
+    // that were already within unchanged
+    return cartesian_coordinates - lat.column_vector_matrix() * lattice_translations;
+}
+
+Eigen::Matrix3Xd bring_within_wigner_seitz_batch(const Eigen::Ref<const Eigen::Matrix3Xd>& cartesian_coordinates,
+                                                 const Lattice& lat)
+{
+    // The voronoi table is built once for the CASM lattice and shared by every coordinate
+    const CASM::xtal::Lattice& casm_lat = lat.__get();
+    Eigen::Matrix3Xd within_coordinates(3, cartesian_coordinates.cols());
+    for (Eigen::Index ix = 0; ix < cartesian_coordinates.cols(); ++ix)
+    {
+        CASM::xtal::Coordinate casm_coord(cartesian_coordinates.col(ix), casm_lat, CASM::CART);
+        casm_coord.voronoi_within();
+        within_coordinates.col(ix) = casm_coord.cart();
+    }
+    return within_coordinates;
+}
+
 CoordinateEquals_f::CoordinateEquals_f(double tol) : tol(tol) {}
 bool CoordinateEquals_f::operator()(const Eigen::Vector3d& ref, const Eigen::Vector3d& other) const
 {
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <casmutils/exceptions.hpp>
+#include <casmutils/xtal/fingerprint.hpp>
+#include <casmutils/xtal/species.hpp>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace
+{
+/// 64 bit FNV-1a. Unlike std::hash, it gives the same value on every platform and every run.
+/// Numbers are fed in one byte at a time, least significant first, so byte order doesn't matter either.
+class StableHasher
+{
+public:
+    void add(std::uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            this->add_byte(static_cast<unsigned char>(value >> (8 * i)));
+        }
+    }
+
+    void add(const std::string& value)
+    {
+        this->add(static_cast<std::uint64_t>(value.size()));
+        for (char c : value)
+        {
+            this->add_byte(static_cast<unsigned char>(c));
+        }
+    }
+
+    std::uint64_t value() const { return this->hash; }
+
+private:
+    std::uint64_t hash = 0xcbf29ce484222325;
+
+    void add_byte(unsigned char byte)
+    {
+        this->hash ^= byte;
+        this->hash *= 0x100000001b3;
+    }
+};
+
+/// Width of the gaussian each neighbour adds to the histogram, in units of the bin width
+constexpr double smearing_width = 0.5;
+
+/// Neighbours further than this many smearing widths from a bin don't add to it. The gaussian is
+/// shifted down so that it reaches zero at the cutoff, which keeps the histogram continuous as
+/// neighbours come in and out of reach.
+constexpr double smearing_cutoff = 5.0;
+
+/// Resolution of the values that go into the hash. These are coarse compared to any sensible
+/// tolerance, so that equivalent structures rarely end up on either side of a rounding boundary.
+constexpr double hash_log_volume_resolution = 0.005;
+constexpr double hash_histogram_resolution = 0.05;
+} // namespace
+
+namespace casmutils
+{
+namespace xtal
+{
+std::uint64_t StructureFingerprint::hash() const
+{
+    StableHasher hasher;
+    hasher.add(this->composition_hash);
+    hasher.add(std::llround(std::log(this->volume_per_atom) / hash_log_volume_resolution));
+    for (double count : this->distance_histogram)
+    {
+        hasher.add(std::llround(count / hash_histogram_resolution));
+    }
+    return hasher.value();
+}
+
+StructureFingerprint fingerprint(const Structure& struc, double tol)
+{
+    const std::vector<int>& species_ids = struc.species_ids();
+    const int n_atoms = species_ids.size();
+    if (n_atoms == 0)
+    {
+        throw except::UserInputMangle("Can't make a fingerprint of a structure without any atoms");
+    }
+
+    StructureFingerprint result;
+    result.tol = tol;
+
+    std::map<std::string, int> species_counts;
+    for (int id : species_ids)
+    {
+        ++species_counts[species_name(id)];
+    }
+    int count_divisor = 0;
+    for (const auto& [name, count] : species_counts)
+    {
+        count_divisor = std::gcd(count_divisor, count);
+    }
+    StableHasher composition_hasher;
+    for (const auto& [name, count] : species_counts)
+    {
+        composition_hasher.add(name);
+        composition_hasher.add(static_cast<std::uint64_t>(count / count_divisor));
+    }
+    result.composition_hash = composition_hasher.value();
+
+    const Lattice& lat = struc.lattice();
+    result.volume_per_atom = std::abs(lat.volume()) / n_atoms;
+    const double length_unit = std::cbrt(result.volume_per_atom);
+
+    const double bin_width = StructureFingerprint::histogram_range / StructureFingerprint::histogram_bins;
+    const double sigma = smearing_width * bin_width;
+    const double reach = smearing_cutoff * sigma;
+    const double gaussian_at_cutoff = std::exp(-0.5 * smearing_cutoff * smearing_cutoff);
+    const double max_distance = (StructureFingerprint::histogram_range + reach) * length_unit;
+
+    // Work with every atom inside the cell, and find how many periodic images in each direction
+    // are needed to see every neighbour within max_distance
+    const Eigen::Matrix3d& lat_mat = lat.column_vector_matrix();
+    const Eigen::Matrix3d& inv_lat_mat = lat.inverse_column_vector_matrix();
+    Eigen::Matrix3Xd frac_coords = inv_lat_mat * struc.cart_coords();
+    frac_coords = frac_coords.array() - frac_coords.array().floor();
+    const Eigen::Matrix3Xd cart_coords = lat_mat * frac_coords;
+
+    Eigen::Vector3i image_range;
+    for (int k = 0; k < 3; ++k)
+    {
+        image_range(k) = std::ceil(max_distance * inv_lat_mat.row(k).norm()) + 1;
+    }
+    std::vector<Eigen::Vector3d> translations;
+    for (int i = -image_range(0); i <= image_range(0); ++i)
+    {
+        for (int j = -image_range(1); j <= image_range(1); ++j)
+        {
+            for (int k = -image_range(2); k <= image_range(2); ++k)
+            {
+                translations.push_back(lat_mat * Eigen::Vector3d(i, j, k));
+            }
+        }
+    }
+
+    result.distance_histogram.fill(0);
+    std::array<double, StructureFingerprint::histogram_bins> nearby_neighbours;
+    nearby_neighbours.fill(0);
+    for (int i = 0; i < n_atoms; ++i)
+    {
+        for (int j = 0; j < n_atoms; ++j)
+        {
+            const Eigen::Vector3d separation = cart_coords.col(j) - cart_coords.col(i);
+            for (const Eigen::Vector3d& translation : translations)
+            {
+                double distance = (separation + translation).norm();
+                if (distance < tol || distance > max_distance)
+                {
+                    continue;
+                }
+
+                double scaled_distance = distance / length_unit;
+                int first_bin = std::max(0, int(std::ceil((scaled_distance - reach) / bin_width - 0.5)));
+                int last_bin = std::min(StructureFingerprint::histogram_bins - 1,
+                                        int(std::floor((scaled_distance + reach) / bin_width - 0.5)));
+                for (int bin = first_bin; bin <= last_bin; ++bin)
+                {
+                    double offset = ((bin + 0.5) * bin_width - scaled_distance) / sigma;
+                    double weight = std::exp(-0.5 * offset * offset) - gaussian_at_cutoff;
+                    result.distance_histogram[bin] += std::max(0.0, weight);
+                    nearby_neighbours[bin] += 1;
+                }
+            }
+        }
+    }
+
+    // Moving every atom by up to tol changes a distance by up to 2*tol, and the length unit by about tol.
+    // No neighbour can then change a bin by more than that change times the steepest slope of the gaussian.
+    const double steepest_slope = 1.0 / (sigma * std::sqrt(std::exp(1.0)));
+    for (int bin = 0; bin < StructureFingerprint::histogram_bins; ++bin)
+    {
+        double scaled_change = (2 + (bin + 0.5) * bin_width) * tol / length_unit;
+        result.distance_histogram[bin] /= n_atoms;
+        result.histogram_tolerance[bin] = nearby_neighbours[bin] / n_atoms * scaled_change * steepest_slope;
+    }
+
+    return result;
+}
+
+bool could_be_equivalent(const StructureFingerprint& lhs, const StructureFingerprint& rhs)
+{
+    if (lhs.composition_hash != rhs.composition_hash)
+    {
+        return false;
+    }
+
+    // Moving each lattice vector by tol changes the volume per atom by about 3*tol*a^2, where a is the cube
+    // root of the volume per atom
+    double max_volume = std::max(lhs.volume_per_atom, rhs.volume_per_atom);
+    double volume_tol = 3 * std::max(lhs.tol, rhs.tol) * std::pow(max_volume, 2.0 / 3.0);
+    if (std::abs(lhs.volume_per_atom - rhs.volume_per_atom) > volume_tol)
+    {
+        return false;
+    }
+
+    // Small slack for rounding
+    const double slack = 1e-9;
+    for (int bin = 0; bin < StructureFingerprint::histogram_bins; ++bin)
+    {
+        double bin_tol = lhs.histogram_tolerance[bin] + rhs.histogram_tolerance[bin] + slack;
+        if (std::abs(lhs.distance_histogram[bin] - rhs.distance_histogram[bin]) > bin_tol)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace xtal
+} // namespace casmutils
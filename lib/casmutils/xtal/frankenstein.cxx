@@ -56,36 +56,45 @@ xtal::Structure stack(std::vector<xtal::Structure> sub_strucs)
     }
 
     // We now have a template lattice with the right shape, we'll put the
-    // sites inside in a second. It already has the basis for the bottom of
-    // the stack
+    // sites inside in a second
     xtal::Lattice stacked_lat(stacked_lat_mat);
-    std::vector<xtal::Site> stacked_basis = sub_strucs[0].basis_sites();
+    int total_sites = 0;
+    for (const auto& s : sub_strucs)
+    {
+        total_sites += s.species_ids().size();
+    }
+    Eigen::Matrix3Xd stacked_coords(3, total_sites);
+    std::vector<int> stacked_species;
+    stacked_species.reserve(total_sites);
 
     // For each structure we stack, we'll take the basis, shift it up by the
     // approprate amount, and stick it into our template stacked structure
     Eigen::Vector3d c_shift = Eigen::Vector3d::Zero();
-    for (int i = 1; i < sub_strucs.size(); i++)
+    for (int i = 0; i < sub_strucs.size(); i++)
     {
         // determine appropriate c-axis shift for position in stacking
-        c_shift += sub_strucs[i - 1].lattice().column_vector_matrix().col(2);
-
-        // Shift each site of the basis by the appropriate c shift,
-        // and adds them to the stacked structure
-        for (const xtal::Site& s : sub_strucs[i].basis_sites())
+        if (i > 0)
         {
-            auto new_coord = s.cart() + c_shift;
-            stacked_basis.push_back(xtal::Site(new_coord, s.label()));
+            c_shift += sub_strucs[i - 1].lattice().column_vector_matrix().col(2);
         }
+
+        // Shift the whole basis by the appropriate c shift,
+        // and add it to the stacked structure
+        const Eigen::Matrix3Xd& sub_coords = sub_strucs[i].cart_coords();
+        stacked_coords.middleCols(stacked_species.size(), sub_coords.cols()) = sub_coords.colwise() + c_shift;
+        stacked_species.insert(
+            stacked_species.end(), sub_strucs[i].species_ids().begin(), sub_strucs[i].species_ids().end());
     }
-    return xtal::Structure(stacked_lat, stacked_basis);
+    return xtal::Structure(stacked_lat, stacked_coords, stacked_species);
 }
 
 std::vector<xtal::Site> translate_basis(const std::vector<xtal::Site>& basis, const Eigen::Vector3d& shift)
 {
     std::vector<xtal::Site> translated_basis;
+    translated_basis.reserve(basis.size());
     for (const auto& site : basis)
     {
-        translated_basis.emplace_back((site.cart() + shift), site.label());
+        translated_basis.emplace_back((site.cart() + shift), site.species());
     }
 
     return translated_basis;
@@ -93,13 +102,8 @@ std::vector<xtal::Site> translate_basis(const std::vector<xtal::Site>& basis, co
 
 xtal::Structure translate_basis(const xtal::Structure& struc, const Eigen::Vector3d& shift)
 {
-    std::vector<xtal::Site> translated_basis;
-    for (const auto& s : struc.basis_sites())
-    {
-        translated_basis.emplace_back((s.cart() + shift), s.label());
-    }
-
-    return xtal::Structure(struc.lattice(), translated_basis);
+    Eigen::Matrix3Xd translated_coords = struc.cart_coords().colwise() + shift;
+    return xtal::Structure(struc.lattice(), translated_coords, struc.species_ids());
 }
 
 std::pair<xtal::Structure, xtal::Structure> slice(const xtal::Structure& big_struc, double slice_loc, double tol)
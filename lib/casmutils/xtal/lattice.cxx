@@ -29,8 +29,13 @@ namespace casmutils
 {
 namespace xtal
 {
-Lattice::Lattice(const CASM::xtal::Lattice& init_lat) : casm_lattice(init_lat) {}
-Lattice::Lattice(const Eigen::Matrix3d& column_lat_mat) : casm_lattice(column_lat_mat) {}
+Lattice::Lattice(const CASM::xtal::Lattice& init_lat) : column_lat_mat(init_lat.lat_column_mat())
+{
+    // Hold on to the given lattice, it may have been constructed with a specific tolerance
+    this->casm_lattice.set(init_lat);
+}
+
+Lattice::Lattice(const Eigen::Matrix3d& column_lat_mat) : column_lat_mat(column_lat_mat) {}
 
 Lattice::Lattice(const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c)
     : Lattice(Lattice::stack_column_vectors(a, b, c))
@@ -73,6 +78,22 @@ Lattice::stack_column_vectors(const Eigen::Vector3d& a, const Eigen::Vector3d& b
     return column_matrix;
 }
 
+const Eigen::Matrix3d& Lattice::inverse_column_vector_matrix() const
+{
+    return this->inverse_lat_mat.get([this]() -> Eigen::Matrix3d { return this->column_lat_mat.inverse(); });
+}
+
+const Eigen::Matrix3d& Lattice::metric() const
+{
+    return this->metric_mat.get(
+        [this]() -> Eigen::Matrix3d { return this->column_lat_mat.transpose() * this->column_lat_mat; });
+}
+
+const CASM::xtal::Lattice& Lattice::__get() const
+{
+    return this->casm_lattice.get([this]() { return CASM::xtal::Lattice(this->column_lat_mat); });
+}
+
 LatticeEquals_f::LatticeEquals_f(double tol) : tol(tol) {}
 bool LatticeEquals_f::operator()(const Lattice& ref_lat, const Lattice& other) const
 {
@@ -89,21 +110,22 @@ bool LatticeIsEquivalent_f::operator()(const Lattice& reference, const Lattice&
 
 void make_niggli(Lattice* lattice_ptr)
 {
-    *lattice_ptr = CASM::xtal::niggli(CASM::xtal::Lattice(lattice_ptr->column_vector_matrix()), CASM::TOL);
+    *lattice_ptr = make_niggli(*lattice_ptr);
     return;
 }
 Lattice make_niggli(const Lattice& non_niggli_lattice)
 {
-    Lattice niggli_lattice = non_niggli_lattice;
-    make_niggli(&niggli_lattice);
-    return niggli_lattice;
+    return non_niggli_lattice.niggli_lattice.get([&non_niggli_lattice]() {
+        return Lattice(CASM::xtal::niggli(CASM::xtal::Lattice(non_niggli_lattice.column_vector_matrix()), CASM::TOL));
+    });
 }
 
 Lattice make_reciprocal(const Lattice& real_lattice)
 {
-    auto casm_reciprocal = real_lattice.__get().reciprocal();
-    // TODO: Move constructor for lattice?
-    return Lattice(casm_reciprocal);
+    // Same as CASM::xtal::Lattice::reciprocal, without having to construct the CASM lattice
+    return real_lattice.reciprocal_lattice.get([&real_lattice]() {
+        return Lattice(2 * M_PI * real_lattice.inverse_column_vector_matrix().transpose());
+    });
 }
 
 std::pair<Eigen::Matrix3d, Eigen::Matrix3d> polar_decomposition(Eigen::Matrix3d const& F)
@@ -163,7 +185,8 @@ Lattice make_right_handed(const Lattice& left_handed_lattice)
 
 Lattice make_superlattice(const Lattice& tiling_unit, const Eigen::Matrix3i col_transf_mat)
 {
-    return Lattice(CASM::xtal::make_superlattice(tiling_unit.__get(), col_transf_mat));
+    // Same as CASM::xtal::make_superlattice, without having to construct the CASM lattice
+    return Lattice(tiling_unit.column_vector_matrix() * col_transf_mat.cast<double>());
 }
 } // namespace xtal
 } // namespace casmutils
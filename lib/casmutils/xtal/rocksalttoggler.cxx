@@ -1,28 +1,10 @@
 #include <casmutils/exceptions.hpp>
 #include <casmutils/misc.hpp>
+#include <casmutils/xtal/coordinate.hpp>
 #include <casmutils/xtal/rocksalttoggler.hpp>
 #include <casmutils/xtal/structure.hpp>
 #include <casmutils/xtal/structure_tools.hpp>
 
-namespace
-{
-// Please never use this outisde of the RockSalt context
-void set_site_occupant(CASM::xtal::Site* mutating_site, std::string new_occ)
-{
-    throw except::NotImplemented();
-    /* if (new_occ == "Va") */
-    /* { */
-    /*     mutating_site->set_occ_value(0); */
-    /*     assert(mutating_site->allowed_occupants()[0] == "Va"); */
-    /* } */
-
-    /* else */
-    /* { */
-    /*     mutating_site->set_occ_value(1); */
-    /* } */
-}
-} // namespace
-
 namespace enumeration
 {
 
@@ -231,76 +213,49 @@ void RockSaltOctahedraToggler::commit() const
 
 void RockSaltOctahedraToggler::commit_central_ions() const
 {
-    throw except::NotImplemented();
-    /* for (const auto& ix_is_on : this->central_ion_is_on) */
-    /* { */
-    /*     auto ix = ix_is_on.first; */
-    /*     auto is_on = ix_is_on.second; */
-
-    /*     if (is_on) */
-    /*     { */
-    /*         ::set_site_occupant(&this->rocksalt_struc.basis[ix], this->central_ion_name); */
-    /*     } */
-
-    /*     else */
-    /*     { */
-    /*         ::set_site_occupant(&this->rocksalt_struc.basis[ix], "Va"); */
-    /*     } */
-    /* } */
+    for (const auto& ix_is_on : this->central_ion_is_on)
+    {
+        auto ix = ix_is_on.first;
+        auto is_on = ix_is_on.second;
+        this->rocksalt_struc.set_species(ix, is_on ? this->central_ion_name : "Va");
+    }
     return;
 }
 
 void RockSaltOctahedraToggler::commit_vertex_ions() const
 {
-    throw except::NotImplemented();
-    /* for (const auto& ix_count : this->leashed_vertex_ions) */
-    /* { */
-    /*     auto ix = ix_count.first; */
-    /*     auto count = ix_count.second; */
-
-    /*     if (count > 0) */
-    /*     { */
-    /*         ::set_site_occupant(&this->rocksalt_struc.basis[ix], this->vertex_ion_name); */
-    /*     } */
-
-    /*     else */
-    /*     { */
-    /*         ::set_site_occupant(&this->rocksalt_struc.basis[ix], "Va"); */
-    /*     } */
-    /* } */
+    for (const auto& ix_count : this->leashed_vertex_ions)
+    {
+        auto ix = ix_count.first;
+        auto count = ix_count.second;
+        this->rocksalt_struc.set_species(ix, count > 0 ? this->vertex_ion_name : "Va");
+    }
     return;
 }
 
 RockSaltOctahedraToggler::index RockSaltOctahedraToggler::coordinate_to_index(Coordinate coordinate) const
 {
-    throw except::NotImplemented();
-    // TODO: Bring the coordinate within relative to the rocksalt structure lattice before making any comparisons
-    //    coordinate.bring_within(this->rocksalt_struc.lattice());
-    //    // Go through the basis of the structure
-    //    // and find out which basis index the
-    //    // given coordinate corresponds to
-    //    auto basis = this->rocksalt_struc.basis_sites();
-    //    for (int ix = 0; ix < basis.size(); ++ix)
-    //    {
-    //        if (casmutils::is_equal<casmutils::xtal::CoordinateEquals_f>(
-    //                static_cast<Coordinate>(basis[ix]), coordinate, 1e-5))
-    //        {
-    //            return ix;
-    //        }
-    //    }
-    //
-    //    throw except::IncompatibleCoordinate();
+    // Removing whole lattice translations from the difference to every site means that a coordinate
+    // outside the cell, or on the opposite face of it, still finds its site. Rounding the fractional
+    // differences doesn't always give the shortest image, but it does for a site within the tolerance.
+    const Lattice& lat = this->rocksalt_struc.lattice();
+    Eigen::Matrix3Xd frac_differences =
+        casmutils::xtal::cartesian_to_fractional_batch(this->rocksalt_struc.cart_coords().colwise() - coordinate, lat);
+    frac_differences -= frac_differences.array().round().matrix();
+    Eigen::Matrix3Xd differences = casmutils::xtal::fractional_to_cartesian_batch(frac_differences, lat);
+
+    index nearest_ix;
+    double nearest_distance = differences.colwise().norm().minCoeff(&nearest_ix);
+    if (nearest_distance > 1e-5)
+    {
+        throw except::IncompatibleCoordinate();
+    }
+    return nearest_ix;
 }
 
 RockSaltOctahedraToggler::Coordinate RockSaltOctahedraToggler::index_to_coordinate(index coordinate_index) const
 {
-    throw except::NotImplemented();
-    /* // Go through the basis of the structure */
-    /* // and find out which coordinate the */
-    /* // given index corresponds to */
-    /* const auto& coord = rocksalt_struc.basis[coordinate_index]; */
-    /* return coord; */
-    /* // TODO: explicitly cast for clairty? */
+    return this->rocksalt_struc.cart_coords().col(coordinate_index);
 }
 
 RockSaltOctahedraToggler::Structure
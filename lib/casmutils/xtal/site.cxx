@@ -3,6 +3,7 @@
 #include "casmutils/misc.hpp"
 #include "casmutils/xtal/coordinate.hpp"
 #include "casmutils/xtal/lattice.hpp"
+#include "casmutils/xtal/species.hpp"
 
 namespace extend
 {
@@ -14,32 +15,31 @@ namespace xtal
 {
 
 Site::Site(const Eigen::Vector3d& init_coord, const std::string& occupant_name)
-    : casm_site(CASM::xtal::Site(CASM::xtal::Coordinate(init_coord, CASM::xtal::Lattice(), CASM::CART), occupant_name))
+    : cart_coord(init_coord), occupant_id(xtal::species_id(occupant_name))
 {
-    // Avoid a multioccupant site
-    assert(casm_site.allowed_occupants().size() == 1);
-    // Avoid an unitialized state.
-    this->casm_site.set_label(0);
 }
 
-Site::Site(const CASM::xtal::Site& init_site, int occupant) : casm_site(init_site)
+Site::Site(const Eigen::Vector3d& init_coord, int occupant_species_id)
+    : cart_coord(init_coord), occupant_id(occupant_species_id)
 {
-    // Avoid an unitialized state.
-    this->casm_site.set_label(occupant);
 }
-std::string Site::label() const { return this->casm_site.allowed_occupants()[this->casm_site.label()]; }
 
-Eigen::Vector3d Site::cart() const { return this->casm_site.cart(); }
+Site::Site(const CASM::xtal::Site& init_site, int occupant)
+    : cart_coord(init_site.cart()), occupant_id(xtal::species_id(init_site.allowed_occupants()[occupant]))
+{
+}
+
+const std::string& Site::label() const { return species_name(this->occupant_id); }
 
 Eigen::Vector3d Site::frac(const Lattice& ref_lattice) const
 {
-    return ref_lattice.column_vector_matrix().inverse() * this->cart();
+    return ref_lattice.inverse_column_vector_matrix() * this->cart();
 }
 
 SiteEquals_f::SiteEquals_f(double tol) : tol(tol) {}
 bool SiteEquals_f::operator()(const Site& ref_site, const Site& other) const
 {
-    return is_equal<CoordinateEquals_f>(ref_site.cart(), other.cart(), tol) && ref_site.label() == other.label();
+    return ref_site.species() == other.species() && is_equal<CoordinateEquals_f>(ref_site.cart(), other.cart(), tol);
 }
 
 } // namespace xtal
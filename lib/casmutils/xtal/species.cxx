@@ -0,0 +1,104 @@
+#include "casmutils/xtal/species.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+/// Names are stored in fixed size chunks that never move, so that references handed out by
+/// species_name remain valid while new names get registered. Looking up a name by id doesn't
+/// take any lock: a name is written before the count that makes it visible is published.
+struct SpeciesTable
+{
+    static constexpr int chunk_size = 256;
+    static constexpr int max_chunks = 4096;
+
+    /// Guards ids, and serializes registering new names
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, int> ids;
+
+    std::array<std::atomic<std::string*>, max_chunks> name_chunks{};
+    std::atomic<int> name_count{0};
+
+    ~SpeciesTable()
+    {
+        for (std::atomic<std::string*>& chunk : name_chunks)
+        {
+            delete[] chunk.load();
+        }
+    }
+};
+
+SpeciesTable& species_table()
+{
+    static SpeciesTable table;
+    return table;
+}
+} // namespace
+
+namespace casmutils
+{
+namespace xtal
+{
+int species_id(const std::string& species_name)
+{
+    SpeciesTable& table = species_table();
+    {
+        std::shared_lock<std::shared_mutex> read_lock(table.mutex);
+        auto found = table.ids.find(species_name);
+        if (found != table.ids.end())
+        {
+            return found->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> write_lock(table.mutex);
+    // Someone else may have registered the name while we were waiting for the lock
+    auto found = table.ids.find(species_name);
+    if (found != table.ids.end())
+    {
+        return found->second;
+    }
+
+    int new_id = table.name_count.load(std::memory_order_relaxed);
+    if (new_id == SpeciesTable::chunk_size * SpeciesTable::max_chunks)
+    {
+        throw std::length_error("Too many species names have been registered");
+    }
+    std::atomic<std::string*>& chunk = table.name_chunks[new_id / SpeciesTable::chunk_size];
+    if (chunk.load(std::memory_order_relaxed) == nullptr)
+    {
+        chunk.store(new std::string[SpeciesTable::chunk_size], std::memory_order_relaxed);
+    }
+    chunk.load(std::memory_order_relaxed)[new_id % SpeciesTable::chunk_size] = species_name;
+    table.ids.emplace(species_name, new_id);
+    table.name_count.store(new_id + 1, std::memory_order_release);
+    return new_id;
+}
+
+const std::string& species_name(int species_id)
+{
+    SpeciesTable& table = species_table();
+    int registered_count = table.name_count.load(std::memory_order_acquire);
+    if (species_id < 0 || species_id >= registered_count)
+    {
+        throw std::out_of_range("Species id " + std::to_string(species_id) + " is out of range, only " +
+                                std::to_string(registered_count) + " species have been registered");
+    }
+    return table.name_chunks[species_id / SpeciesTable::chunk_size].load(
+        std::memory_order_relaxed)[species_id % SpeciesTable::chunk_size];
+}
+
+int species_count() { return species_table().name_count.load(std::memory_order_acquire); }
+
+bool is_vacancy(const std::string& species_name)
+{
+    return species_name == "Va" || species_name == "VA" || species_name == "va";
+}
+} // namespace xtal
+} // namespace casmutils
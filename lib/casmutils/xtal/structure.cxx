@@ -6,90 +6,346 @@
 #include <casmutils/exceptions.hpp>
 #include <casmutils/misc.hpp>
 #include <casmutils/xtal/coordinate.hpp>
+#include <casmutils/xtal/species.hpp>
 #include <casmutils/xtal/structure.hpp>
+#include <cctype>
+#include <charconv>
+#include <cmath>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 namespace extend
 {
 } // namespace extend
 
-namespace casmutils
+namespace
 {
-namespace xtal
+/// Removes every value whose index is flagged, keeping the order of the remaining values
+template <typename ValueType> void erase_flagged(std::vector<ValueType>* values, const std::vector<bool>& is_flagged)
+{
+    int kept = 0;
+    for (int ix = 0; ix < is_flagged.size(); ++ix)
+    {
+        if (!is_flagged[ix])
+        {
+            // Avoid self move assignment, which leaves some types (e.g. std::vector) empty
+            if (kept != ix)
+            {
+                (*values)[kept] = std::move((*values)[ix]);
+            }
+            ++kept;
+        }
+    }
+    values->erase(values->begin() + kept, values->end());
+}
 
+/// Walks through the text of a POSCAR one line at a time, converting values straight out of
+/// the text without copying them into intermediate strings or streams.
+class PoscarTokenizer
 {
+public:
+    PoscarTokenizer(std::string_view text) : m_remaining(text) {}
 
-// TODO: Does it work to just have the _update_using calls be used during __get?
-// Then always have the rewrap representation be the state of the structure, and
-// whenever you need a CASM implementation, just get it via __get, which would automatically
-// update it to the correct state. This might allow us to have the basis
-// as a public member, so that you could easily add, remove or edit sites without doing
-// an entire reset.
+    /// Moves on to the next line of the text. The name of what's expected on the line is only
+    /// used to report errors.
+    void next_line(const char* expected)
+    {
+        if (m_remaining.empty())
+        {
+            throw except::BadPOSCAR(std::string("reached the end of the file while looking for ") + expected);
+        }
+        std::size_t line_end = m_remaining.find('\n');
+        m_line = m_remaining.substr(0, line_end);
+        m_remaining = line_end == std::string_view::npos ? std::string_view() : m_remaining.substr(line_end + 1);
+    }
 
-template <> void Structure::_update_using<CASM::xtal::BasicStructure>()
-{
-    _update_simple_from_basic();
-    _update_internals_from_basic();
-}
+    /// Returns the first character of the current line that isn't whitespace, or '\0' for a blank line
+    char peek() const
+    {
+        std::size_t start = m_line.find_first_not_of(whitespace);
+        return start == std::string_view::npos ? '\0' : m_line[start];
+    }
+
+    /// Removes the next whitespace separated value from the current line, returns an empty
+    /// value if there is nothing left on the line
+    std::string_view next_token()
+    {
+        std::size_t start = m_line.find_first_not_of(whitespace);
+        if (start == std::string_view::npos)
+        {
+            m_line = std::string_view();
+            return m_line;
+        }
+        std::size_t end = m_line.find_first_of(whitespace, start);
+        std::string_view token = m_line.substr(start, end == std::string_view::npos ? end : end - start);
+        m_line = end == std::string_view::npos ? std::string_view() : m_line.substr(end);
+        return token;
+    }
+
+    double next_double(const char* expected) { return next_number<double>(expected); }
+
+    int next_int(const char* expected) { return next_number<int>(expected); }
 
-template <> void Structure::_update_using<CASM::xtal::SimpleStructure>()
+private:
+    static constexpr const char* whitespace = " \t\r";
+
+    template <typename NumberType> NumberType next_number(const char* expected)
+    {
+        std::string_view token = next_token();
+        // from_chars doesn't accept an explicit positive sign
+        if (!token.empty() && token.front() == '+')
+        {
+            token.remove_prefix(1);
+        }
+        NumberType value;
+        auto [end, err] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (token.empty() || err != std::errc() || end != token.data() + token.size())
+        {
+            throw except::BadPOSCAR("expected " + std::string(expected) + ", but found '" + std::string(token) + "'");
+        }
+        return value;
+    }
+
+    std::string_view m_remaining;
+    std::string_view m_line;
+};
+} // namespace
+
+namespace casmutils
 {
-    _update_basic_from_simple();
-    _update_internals_from_simple();
-}
+namespace xtal
 
-template <> void Structure::_update_using<casmutils::xtal::Structure>()
 {
-    _update_basic_from_internals();
-    _update_simple_from_internals();
-}
 
-/// Return *this as a CASM::BasicStructure
+/// Return *this as a CASM::SimpleStructure
 template <> const CASM::xtal::SimpleStructure& Structure::__get<CASM::xtal::SimpleStructure>() const
 {
-    return this->casm_simplestructure;
+    return this->casm_simplestructure.get([this]() { return this->_make_simple_from_internals(); });
 }
 
 /// Return *this as a CASM::BasicStructure
 template <> const CASM::xtal::BasicStructure& Structure::__get<CASM::xtal::BasicStructure>() const
 {
-    return this->casm_basicstructure;
+    return this->casm_basicstructure.get([this]() { return this->_make_basic_from_internals(); });
 }
 
-Structure::Structure(const CASM::xtal::BasicStructure& init_struc)
-    : structure_lattice(init_struc.lattice()), casm_basicstructure(init_struc)
+Structure::Structure(const CASM::xtal::BasicStructure& init_struc) : structure_lattice(init_struc.lattice())
 {
-    _update_using<CASM::xtal::BasicStructure>();
+    _update_internals_from_basic(init_struc);
+    // The structure we were given is already up to date, no need to rebuild it later
+    this->casm_basicstructure.set(init_struc);
 }
 
-Structure::Structure(const CASM::xtal::SimpleStructure& init_struc)
-    : structure_lattice(init_struc.lat_column_mat), casm_simplestructure(init_struc)
+Structure::Structure(const CASM::xtal::SimpleStructure& init_struc) : structure_lattice(init_struc.lat_column_mat)
 {
-    _update_using<CASM::xtal::SimpleStructure>();
+    _update_internals_from_simple(init_struc);
+    // The structure we were given is already up to date, no need to rebuild it later
+    this->casm_simplestructure.set(init_struc);
 }
 
-Structure::Structure(const Lattice& init_lat, const std::vector<Site>& init_basis)
-    : structure_lattice(init_lat), basis(init_basis)
+Structure::Structure(const Lattice& init_lat, const std::vector<Site>& init_basis) : structure_lattice(init_lat)
 {
-    _update_using<casmutils::xtal::Structure>();
+    Eigen::Matrix3Xd& cart_coords = this->basis_cart_coords.write();
+    std::vector<int>& species_ids = this->basis_species_ids.write();
+    cart_coords.resize(3, init_basis.size());
+    species_ids.reserve(init_basis.size());
+    for (int ix = 0; ix < init_basis.size(); ++ix)
+    {
+        cart_coords.col(ix) = init_basis[ix].cart();
+        species_ids.push_back(init_basis[ix].species());
+    }
+    this->basis.set(init_basis);
+}
+
+Structure::Structure(const Lattice& init_lat,
+                     const Eigen::Matrix3Xd& init_cart_coords,
+                     const std::vector<int>& init_species_ids)
+    : structure_lattice(init_lat), basis_cart_coords(init_cart_coords), basis_species_ids(init_species_ids)
+{
+    if (init_cart_coords.cols() != init_species_ids.size())
+    {
+        throw std::invalid_argument("The number of coordinates and species ids for the basis don't match");
+    }
+    int registered_count = species_count();
+    for (int id : init_species_ids)
+    {
+        if (id < 0 || id >= registered_count)
+        {
+            throw std::invalid_argument("Species id " + std::to_string(id) +
+                                        " was never registered (see species.hpp)");
+        }
+    }
 }
 
 Structure Structure::from_poscar(const fs::path& poscar_path)
 {
-    if (!fs::exists(poscar_path))
+    // Directories can be opened on some platforms, but tellg() gives nonsense for them
+    if (!fs::is_regular_file(poscar_path))
+    {
+        throw except::BadPath(poscar_path);
+    }
+    // Read the whole file with a single call, and parse straight out of the buffer.
+    // Unreadable files can't be opened or measured.
+    std::ifstream infile(poscar_path, std::ios::binary | std::ios::ate);
+    std::streamoff file_size = infile.is_open() ? static_cast<std::streamoff>(infile.tellg()) : -1;
+    if (file_size < 0)
     {
         throw except::BadPath(poscar_path);
     }
-    std::ifstream infile(poscar_path);
-    CASM::xtal::BasicStructure pos = CASM::xtal::BasicStructure::from_poscar_stream(infile);
-    return casmutils::xtal::Structure(pos);
+    std::string poscar_text(static_cast<std::size_t>(file_size), '\0');
+    infile.seekg(0);
+    if (!infile.read(poscar_text.data(), poscar_text.size()))
+    {
+        throw except::BadPath(poscar_path);
+    }
+    return Structure::from_poscar_string(poscar_text);
+}
+
+Structure Structure::from_poscar_stream(std::istream& poscar_stream)
+{
+    std::ostringstream poscar_text;
+    poscar_text << poscar_stream.rdbuf();
+    return Structure::from_poscar_string(poscar_text.str());
+}
+
+Structure Structure::from_poscar_string(std::string_view poscar_text)
+{
+    PoscarTokenizer poscar(poscar_text);
+
+    // The first line is a comment
+    poscar.next_line("the title");
+
+    poscar.next_line("the scaling factor");
+    double scale = poscar.next_double("the scaling factor");
+
+    // Lattice vectors are given as rows
+    Eigen::Matrix3d lat_mat;
+    for (int i = 0; i < 3; ++i)
+    {
+        poscar.next_line("a lattice vector");
+        for (int j = 0; j < 3; ++j)
+        {
+            lat_mat(j, i) = poscar.next_double("a lattice vector component");
+        }
+    }
+
+    // A negative scaling factor is the volume of the cell instead
+    if (scale < 0)
+    {
+        scale = std::cbrt(-scale / std::abs(lat_mat.determinant()));
+    }
+    lat_mat *= scale;
+
+    // VASP 5 lists the species names before the number of each species. VASP 4 doesn't,
+    // in which case we expect the name of the species at the end of each coordinate line.
+    poscar.next_line("the species names or counts");
+    std::vector<std::string> names_line;
+    if (std::isalpha(static_cast<unsigned char>(poscar.peek())))
+    {
+        for (std::string_view name = poscar.next_token(); !name.empty(); name = poscar.next_token())
+        {
+            names_line.emplace_back(name);
+        }
+        poscar.next_line("the species counts");
+    }
+
+    std::vector<int> species_counts;
+    while (std::isdigit(static_cast<unsigned char>(poscar.peek())))
+    {
+        species_counts.push_back(poscar.next_int("a species count"));
+    }
+    if (species_counts.empty() || (!names_line.empty() && names_line.size() != species_counts.size()))
+    {
+        throw except::BadPOSCAR("the species names and counts don't match");
+    }
+
+    poscar.next_line("the coordinate mode");
+    bool is_selective_dynamics = poscar.peek() == 'S' || poscar.peek() == 's';
+    if (is_selective_dynamics)
+    {
+        poscar.next_line("the coordinate mode");
+    }
+    char mode_key = poscar.peek();
+    bool is_cartesian = mode_key == 'C' || mode_key == 'c' || mode_key == 'K' || mode_key == 'k';
+
+    int total_sites = 0;
+    for (int count : species_counts)
+    {
+        total_sites += count;
+    }
+
+    Eigen::Matrix3Xd coords(3, total_sites);
+    std::vector<int> species_ids;
+    species_ids.reserve(total_sites);
+    for (int s = 0; s < species_counts.size(); ++s)
+    {
+        int id = names_line.empty() ? -1 : species_id(names_line[s]);
+        for (int k = 0; k < species_counts[s]; ++k)
+        {
+            poscar.next_line("a basis coordinate");
+            int ix = species_ids.size();
+            for (int j = 0; j < 3; ++j)
+            {
+                coords(j, ix) = poscar.next_double("a basis coordinate component");
+            }
+
+            if (is_selective_dynamics)
+            {
+                // The flags don't carry over to the structure
+                for (int j = 0; j < 3; ++j)
+                {
+                    poscar.next_token();
+                }
+            }
+
+            if (names_line.empty())
+            {
+                std::string_view name = poscar.next_token();
+                if (name.empty())
+                {
+                    throw except::BadPOSCAR("no species names were given");
+                }
+                species_ids.push_back(species_id(std::string(name)));
+            }
+            else
+            {
+                species_ids.push_back(id);
+            }
+        }
+    }
+
+    // Cartesian coordinates are scaled along with the lattice, fractional ones are relative to it
+    if (is_cartesian)
+    {
+        coords *= scale;
+    }
+    else
+    {
+        coords = lat_mat * coords;
+    }
+
+    return Structure(Lattice(lat_mat), coords, species_ids);
 }
 
 const Lattice& Structure::lattice() const { return this->structure_lattice; }
 
 void Structure::set_lattice(const Lattice& new_lattice, COORD_TYPE mode)
 {
-    this->casm_basicstructure.set_lattice(CASM::xtal::Lattice(new_lattice.column_vector_matrix()), mode);
-    _update_using<CASM::xtal::BasicStructure>();
+    if (mode == FRAC)
+    {
+        // Keep fractional coordinates fixed with a single transformation of the whole basis
+        Eigen::Matrix3d cart_transformation =
+            new_lattice.column_vector_matrix() * this->structure_lattice.inverse_column_vector_matrix();
+        this->basis_cart_coords.reset(cart_transformation * this->basis_cart_coords.read());
+        this->basis.invalidate();
+    }
+
+    // Keeping the Cartesian coordinates doesn't touch the basis at all, it stays shared with any copies
+    this->structure_lattice = new_lattice;
+    this->casm_simplestructure.invalidate();
+    this->casm_basicstructure.invalidate();
     return;
 }
 
@@ -102,88 +358,214 @@ void Structure::set_lattice(const Lattice& new_lattice, COORD_TYPE mode)
 
 void Structure::within()
 {
-    this->casm_basicstructure.within();
-    _update_using<CASM::xtal::BasicStructure>();
+    this->basis_cart_coords.reset(bring_within_lattice_batch(this->basis_cart_coords.read(), this->structure_lattice));
+
+    _invalidate_casm_representations();
     return;
 }
 
-const std::vector<Site>& Structure::basis_sites() const { return this->basis; }
+const std::vector<Site>& Structure::basis_sites() const
+{
+    return this->basis.get([this]() {
+        const Eigen::Matrix3Xd& cart_coords = this->basis_cart_coords.read();
+        const std::vector<int>& species_ids = this->basis_species_ids.read();
+        std::vector<Site> sites;
+        sites.reserve(species_ids.size());
+        for (int ix = 0; ix < species_ids.size(); ++ix)
+        {
+            sites.emplace_back(cart_coords.col(ix), species_ids[ix]);
+        }
+        return sites;
+    });
+}
+
+const Eigen::Matrix3Xd& Structure::cart_coords() const { return this->basis_cart_coords.read(); }
+
+const std::vector<int>& Structure::species_ids() const { return this->basis_species_ids.read(); }
 
-void Structure::_update_simple_from_basic()
+void Structure::add_site(const Site& new_site)
 {
-    this->casm_simplestructure = CASM::xtal::make_simple_structure(this->__get<CASM::xtal::BasicStructure>());
+    Eigen::Matrix3Xd& cart_coords = this->basis_cart_coords.write();
+    int new_index = cart_coords.cols();
+    cart_coords.conservativeResize(Eigen::NoChange, new_index + 1);
+    cart_coords.col(new_index) = new_site.cart();
+    this->basis_species_ids.write().push_back(new_site.species());
+    if (!this->basis_occupants.read().empty())
+    {
+        this->basis_occupants.write().emplace_back();
+    }
+
+    this->basis.modify_if_unique([&new_site](std::vector<Site>& sites) { sites.push_back(new_site); });
+    this->casm_basicstructure.modify_if_unique([this, new_index](CASM::xtal::BasicStructure& basic_struc) {
+        basic_struc.set_basis().push_back(this->_make_casm_site(new_index, basic_struc.lattice()));
+    });
+    this->casm_simplestructure.invalidate();
+    return;
 }
 
-void Structure::_update_internals_from_basic()
+void Structure::remove_sites(const std::vector<int>& site_indices)
 {
-    this->structure_lattice = casmutils::xtal::Lattice(this->__get<CASM::xtal::BasicStructure>().lattice());
-    std::vector<casmutils::xtal::Site> new_basis;
-    for (const auto& site : this->__get<CASM::xtal::BasicStructure>().basis())
+    std::vector<bool> is_removed(this->basis_species_ids.read().size(), false);
+    for (int ix : site_indices)
     {
-        new_basis.emplace_back(site, 0);
+        _assert_valid_site_index(ix);
+        is_removed[ix] = true;
     }
-    this->basis = new_basis;
+
+    // Shift the surviving sites down in a single pass
+    Eigen::Matrix3Xd& cart_coords = this->basis_cart_coords.write();
+    int kept = 0;
+    for (int ix = 0; ix < is_removed.size(); ++ix)
+    {
+        if (!is_removed[ix])
+        {
+            cart_coords.col(kept) = cart_coords.col(ix);
+            ++kept;
+        }
+    }
+    cart_coords.conservativeResize(Eigen::NoChange, kept);
+    erase_flagged(&this->basis_species_ids.write(), is_removed);
+    if (!this->basis_occupants.read().empty())
+    {
+        erase_flagged(&this->basis_occupants.write(), is_removed);
+    }
+
+    this->basis.modify_if_unique([&is_removed](std::vector<Site>& sites) { erase_flagged(&sites, is_removed); });
+    this->casm_basicstructure.modify_if_unique([&is_removed](CASM::xtal::BasicStructure& basic_struc) {
+        erase_flagged(&basic_struc.set_basis(), is_removed);
+    });
+    this->casm_simplestructure.invalidate();
+    return;
 }
 
-void Structure::_update_basic_from_simple()
+void Structure::set_species(int site_index, const std::string& species_name)
 {
-    // Syncing Lattice
-    this->casm_basicstructure =
-        CASM::xtal::BasicStructure(CASM::xtal::Lattice(this->__get<CASM::xtal::SimpleStructure>().lat_column_mat));
-    // Lattice has been synced
-    auto& basic_basis = this->casm_basicstructure.set_basis();
-    for (int index = 0; index < this->__get<CASM::xtal::SimpleStructure>().n_atom(); index++)
+    _assert_valid_site_index(site_index);
+    this->basis_species_ids.write()[site_index] = species_id(species_name);
+    if (!this->basis_occupants.read().empty())
     {
-        const auto& info =
-            this->__get<CASM::xtal::SimpleStructure>().info(CASM::xtal::SimpleStructure::SpeciesMode::ATOM);
-        Eigen::Vector3d raw_coord = info.cart_coord(index);
-        basic_basis.emplace_back(
-            CASM::xtal::Coordinate(raw_coord, this->__get<CASM::xtal::BasicStructure>().lattice(), CASM::CART),
-            info.names[index]);
+        // The new species replaces every occupant the site allowed before
+        this->basis_occupants.write()[site_index].clear();
     }
+    _update_single_site(site_index);
+    return;
 }
 
-void Structure::_update_internals_from_simple()
+void Structure::set_cart(int site_index, const Eigen::Vector3d& new_cart_coord)
 {
-    this->structure_lattice = casmutils::xtal::Lattice(casm_simplestructure.lat_column_mat);
-    std::vector<casmutils::xtal::Site> new_basis;
-    for (int index = 0; index < this->__get<CASM::xtal::SimpleStructure>().n_atom(); index++)
+    _assert_valid_site_index(site_index);
+    this->basis_cart_coords.write().col(site_index) = new_cart_coord;
+    _update_single_site(site_index);
+    return;
+}
+
+void Structure::_assert_valid_site_index(int site_index) const
+{
+    int basis_size = this->basis_species_ids.read().size();
+    if (site_index < 0 || site_index >= basis_size)
     {
-        const auto& info =
-            this->__get<CASM::xtal::SimpleStructure>().info(CASM::xtal::SimpleStructure::SpeciesMode::ATOM);
-        Eigen::Vector3d raw_coord = info.cart_coord(index);
-        new_basis.emplace_back(raw_coord, info.names[index]);
+        throw std::out_of_range("Basis site index " + std::to_string(site_index) + " is out of range for a basis of " +
+                                std::to_string(basis_size) + " sites");
     }
-    this->basis = new_basis;
 }
 
-void Structure::_update_basic_from_internals()
+void Structure::_update_single_site(int site_index)
 {
-    // Syncing Lattice
-    this->casm_basicstructure =
-        CASM::xtal::BasicStructure(CASM::xtal::Lattice(this->structure_lattice.column_vector_matrix()));
-    // Lattice has been synced
-    auto& basic_basis = this->casm_basicstructure.set_basis();
-    for (const auto& site : this->basis)
+    Site updated_site(this->basis_cart_coords.read().col(site_index), this->basis_species_ids.read()[site_index]);
+    this->basis.modify_if_unique([&](std::vector<Site>& sites) { sites[site_index] = updated_site; });
+    this->casm_basicstructure.modify_if_unique([&](CASM::xtal::BasicStructure& basic_struc) {
+        basic_struc.set_basis()[site_index] = this->_make_casm_site(site_index, basic_struc.lattice());
+    });
+    // The SimpleStructure holds both atom and molecule information, it's safer to rebuild it
+    this->casm_simplestructure.invalidate();
+    return;
+}
+
+CASM::xtal::Site Structure::_make_casm_site(int site_index, const CASM::xtal::Lattice& casm_lattice) const
+{
+    CASM::xtal::Coordinate casm_coord(this->basis_cart_coords.read().col(site_index), casm_lattice, CASM::CART);
+    const std::vector<std::vector<CASM::xtal::Molecule>>& occupants = this->basis_occupants.read();
+    if (occupants.empty() || occupants[site_index].empty())
     {
-        basic_basis.emplace_back(
-            CASM::xtal::Coordinate(site.cart(), this->__get<CASM::xtal::BasicStructure>().lattice(), CASM::CART),
-            site.label());
+        return CASM::xtal::Site(casm_coord, species_name(this->basis_species_ids.read()[site_index]));
     }
+    return CASM::xtal::Site(casm_coord, occupants[site_index]);
+}
+
+void Structure::_invalidate_casm_representations()
+{
+    this->basis.invalidate();
+    this->casm_simplestructure.invalidate();
+    this->casm_basicstructure.invalidate();
 }
 
-void Structure::_update_simple_from_internals()
+void Structure::_update_internals_from_basic(const CASM::xtal::BasicStructure& basic_struc)
 {
-    // This seems like a horrible way to do this but it's because SimpleStructure only has a
-    // default constructor and a whole bunch of empty fields.
-    // I also didn't want to call _update_basic_from_internals here.
-    CASM::xtal::BasicStructure temp_basic(CASM::xtal::Lattice(this->structure_lattice.column_vector_matrix()));
-    auto& basic_basis = temp_basic.set_basis();
-    for (const auto& site : this->basis)
+    this->structure_lattice = casmutils::xtal::Lattice(basic_struc.lattice());
+    const auto& basic_basis = basic_struc.basis();
+    Eigen::Matrix3Xd cart_coords(3, basic_basis.size());
+    std::vector<int> species_ids;
+    species_ids.reserve(basic_basis.size());
+    bool has_alternative_occupants = false;
+    for (int ix = 0; ix < basic_basis.size(); ++ix)
     {
-        basic_basis.emplace_back(CASM::xtal::Coordinate(site.cart(), temp_basic.lattice(), CASM::CART), site.label());
+        cart_coords.col(ix) = basic_basis[ix].cart();
+        // The first occupant is the species, the rest are kept around for the CASM representation
+        species_ids.push_back(species_id(basic_basis[ix].allowed_occupants()[0]));
+        has_alternative_occupants = has_alternative_occupants || basic_basis[ix].occupant_dof().size() > 1;
     }
-    this->casm_simplestructure = CASM::xtal::make_simple_structure(temp_basic);
+    this->basis_cart_coords.reset(std::move(cart_coords));
+    this->basis_species_ids.reset(std::move(species_ids));
+
+    std::vector<std::vector<CASM::xtal::Molecule>> occupants;
+    if (has_alternative_occupants)
+    {
+        occupants.reserve(basic_basis.size());
+        for (const CASM::xtal::Site& basic_site : basic_basis)
+        {
+            occupants.push_back(basic_site.occupant_dof());
+        }
+    }
+    this->basis_occupants.reset(std::move(occupants));
+    this->basis.invalidate();
+}
+
+void Structure::_update_internals_from_simple(const CASM::xtal::SimpleStructure& simple_struc)
+{
+    this->structure_lattice = casmutils::xtal::Lattice(simple_struc.lat_column_mat);
+    const auto& info = simple_struc.info(CASM::xtal::SimpleStructure::SpeciesMode::ATOM);
+    std::vector<int> species_ids;
+    species_ids.reserve(info.names.size());
+    for (const std::string& name : info.names)
+    {
+        species_ids.push_back(species_id(name));
+    }
+    this->basis_cart_coords.reset(info.coords);
+    this->basis_species_ids.reset(std::move(species_ids));
+    this->basis_occupants.reset({});
+    this->basis.invalidate();
+}
+
+CASM::xtal::BasicStructure Structure::_make_basic_from_internals() const
+{
+    // Syncing Lattice
+    CASM::xtal::BasicStructure basic_struc(CASM::xtal::Lattice(this->structure_lattice.column_vector_matrix()));
+    // Lattice has been synced
+    auto& basic_basis = basic_struc.set_basis();
+    int basis_size = this->basis_cart_coords.read().cols();
+    basic_basis.reserve(basis_size);
+    for (int ix = 0; ix < basis_size; ++ix)
+    {
+        basic_basis.push_back(this->_make_casm_site(ix, basic_struc.lattice()));
+    }
+    return basic_struc;
+}
+
+CASM::xtal::SimpleStructure Structure::_make_simple_from_internals() const
+{
+    // SimpleStructure only has a default constructor and a whole bunch of empty fields,
+    // so go through the BasicStructure representation, which gets cached along the way.
+    return CASM::xtal::make_simple_structure(this->__get<CASM::xtal::BasicStructure>());
 }
 } // namespace xtal
 } // namespace casmutils
@@ -6,12 +6,18 @@
 #include <casm/crystallography/Superlattice.hh>
 #include <casm/crystallography/SuperlatticeEnumerator.hh>
 #include <casm/crystallography/SymTools.hh>
-#include <casm/crystallography/io/VaspIO.hh>
 #include <casmutils/exceptions.hpp>
 #include <casmutils/misc.hpp>
+#include <casmutils/parallel.hpp>
 #include <casmutils/xtal/lattice.hpp>
+#include <casmutils/xtal/species.hpp>
 #include <casmutils/xtal/structure_tools.hpp>
+#include <charconv>
 #include <fstream>
+#include <glob.h>
+#include <limits>
+#include <numeric>
+#include <string>
 namespace
 {
 // surface area of a given lattice
@@ -35,6 +41,61 @@ double boxy_score(const casmutils::xtal::Lattice& lat)
     // i.e. more volume per surface area means more boxy
     return std::abs(lat.volume()) / lattice_surface_area(lat);
 }
+
+// Everything below formats numbers the same way CASM::VaspIO::PrintPOSCAR does through iostreams,
+// so that the POSCAR files stay byte for byte the same.
+
+/// Number of decimal places PrintPOSCAR uses for every value
+constexpr int poscar_precision = 8;
+
+/// Characters needed to print the value with the default stream format, i.e. printf("%.8g")
+int general_width(double value)
+{
+    char digits[64];
+    return std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, poscar_precision).ptr -
+           digits;
+}
+
+/// Prints the value in fixed notation into the given characters, i.e. printf("%.8f"), and returns
+/// how many characters it took. Big enough for any double.
+int format_fixed(double value, char (&digits)[512])
+{
+    return std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, poscar_precision).ptr -
+           digits;
+}
+
+/// Appends a row of three values separated by spaces. If the columns are aligned, every value is
+/// right aligned to the width of the widest value in the row, like Eigen does.
+void append_row(std::string* poscar_buffer, const Eigen::Vector3d& row, bool align_columns)
+{
+    char digits[3][512];
+    int lengths[3];
+    int width = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        lengths[i] = format_fixed(row(i), digits[i]);
+        width = std::max(width, lengths[i]);
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (i > 0)
+        {
+            poscar_buffer->push_back(' ');
+        }
+        if (align_columns)
+        {
+            poscar_buffer->append(width - lengths[i], ' ');
+        }
+        poscar_buffer->append(digits[i], lengths[i]);
+    }
+}
+
+void append_int(std::string* poscar_buffer, int value)
+{
+    char digits[16];
+    poscar_buffer->append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+}
 } // namespace
 
 namespace casmutils
@@ -63,19 +124,212 @@ void make_niggli(Structure* non_niggli)
     return;
 }
 
+std::vector<StructureReadResult> read_structures(const std::vector<fs::path>& poscar_paths, int n_threads)
+{
+    std::vector<StructureReadResult> results(poscar_paths.size());
+    parallel_for(poscar_paths.size(), n_threads, [&](std::size_t ix) {
+        StructureReadResult& result = results[ix];
+        result.path = poscar_paths[ix];
+        try
+        {
+            result.structure.emplace(Structure::from_poscar(poscar_paths[ix]));
+        }
+        catch (const std::exception& e)
+        {
+            result.error = e.what();
+        }
+    });
+    return results;
+}
+
+std::vector<StructureReadResult> read_structures_matching(const std::string& glob_pattern, int n_threads)
+{
+    return read_structures(glob_paths(glob_pattern), n_threads);
+}
+
+std::vector<fs::path> glob_paths(const std::string& glob_pattern)
+{
+    std::vector<fs::path> matched_paths;
+    if (fs::is_directory(glob_pattern))
+    {
+        for (const fs::directory_entry& entry : fs::directory_iterator(glob_pattern))
+        {
+            if (entry.is_regular_file())
+            {
+                matched_paths.push_back(entry.path());
+            }
+        }
+        std::sort(matched_paths.begin(), matched_paths.end());
+        return matched_paths;
+    }
+
+    // glob already sorts what it finds
+    glob_t glob_result;
+    if (::glob(glob_pattern.c_str(), 0, nullptr, &glob_result) == 0)
+    {
+        matched_paths.assign(glob_result.gl_pathv, glob_result.gl_pathv + glob_result.gl_pathc);
+    }
+    ::globfree(&glob_result);
+    return matched_paths;
+}
+
+std::vector<fs::path> read_batch_file(const fs::path& batch_path)
+{
+    return BatchFileReader(batch_path).next(std::numeric_limits<std::size_t>::max());
+}
+
+BatchFileReader::BatchFileReader(const fs::path& batch_path) : batch_file(batch_path)
+{
+    if (!batch_file)
+    {
+        throw except::BadPath(batch_path);
+    }
+}
+
+std::vector<fs::path> BatchFileReader::next(std::size_t max_paths)
+{
+    std::vector<fs::path> listed_paths;
+    std::string line;
+    while (listed_paths.size() < max_paths && std::getline(batch_file, line))
+    {
+        std::size_t start = line.find_first_not_of(" \t\r");
+        if (start != std::string::npos)
+        {
+            std::size_t end = line.find_last_not_of(" \t\r");
+            listed_paths.emplace_back(line.substr(start, end - start + 1));
+        }
+    }
+    return listed_paths;
+}
+
+void format_poscar(const Structure& printable, std::string* poscar_buffer)
+{
+    const Eigen::Matrix3d& lat_mat = printable.lattice().column_vector_matrix();
+    const Eigen::Matrix3d& cart_to_frac = printable.lattice().inverse_column_vector_matrix();
+    const Eigen::Matrix3Xd& cart_coords = printable.cart_coords();
+    const std::vector<int>& species_ids = printable.species_ids();
+
+    // Group the sites by species, keeping the original order within each species
+    std::vector<int> distinct_species;
+    std::vector<std::vector<int>> sites_of_species;
+    for (int site_ix = 0; site_ix < species_ids.size(); ++site_ix)
+    {
+        auto found = std::find(distinct_species.begin(), distinct_species.end(), species_ids[site_ix]);
+        int species_ix = found - distinct_species.begin();
+        if (found == distinct_species.end())
+        {
+            distinct_species.push_back(species_ids[site_ix]);
+            sites_of_species.emplace_back();
+        }
+        sites_of_species[species_ix].push_back(site_ix);
+    }
+
+    // Species are printed in alphabetical order, and vacancies aren't printed at all
+    std::vector<int> species_order(distinct_species.size());
+    std::iota(species_order.begin(), species_order.end(), 0);
+    std::sort(species_order.begin(), species_order.end(), [&](int lhs, int rhs) {
+        return species_name(distinct_species[lhs]) < species_name(distinct_species[rhs]);
+    });
+    auto is_vacancy_species = [&](int species_ix) { return is_vacancy(species_name(distinct_species[species_ix])); };
+    species_order.erase(std::remove_if(species_order.begin(), species_order.end(), is_vacancy_species),
+                        species_order.end());
+
+    std::vector<Eigen::Vector3d> frac_coords;
+    frac_coords.reserve(species_ids.size());
+    for (int species_ix : species_order)
+    {
+        for (int site_ix : sites_of_species[species_ix])
+        {
+            frac_coords.emplace_back(cart_to_frac * cart_coords.col(site_ix));
+        }
+    }
+
+    // PrintPOSCAR works out a column width, but hands it to Eigen::IOFormat as the flags argument.
+    // The only thing that survives is whether the width is odd, which turns on column alignment.
+    int width = 12;
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            width = std::max(width, general_width(lat_mat(j, i)));
+        }
+    }
+    for (const Eigen::Vector3d& frac_coord : frac_coords)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            width = std::max(width, general_width(frac_coord(j)));
+        }
+    }
+    bool align_columns = width % 2 == 1;
+
+    poscar_buffer->clear();
+    // Empty title, and a scaling factor of 1
+    poscar_buffer->append("\n1.00000000\n");
+    for (int i = 0; i < 3; ++i)
+    {
+        append_row(poscar_buffer, lat_mat.col(i), align_columns);
+        poscar_buffer->push_back('\n');
+    }
+
+    if (frac_coords.empty())
+    {
+        return;
+    }
+
+    for (int species_ix : species_order)
+    {
+        poscar_buffer->append(species_name(distinct_species[species_ix]));
+        poscar_buffer->push_back(' ');
+    }
+    poscar_buffer->push_back('\n');
+    for (int species_ix : species_order)
+    {
+        append_int(poscar_buffer, sites_of_species[species_ix].size());
+        poscar_buffer->push_back(' ');
+    }
+    poscar_buffer->append("\nDirect\n");
+
+    auto frac_coord = frac_coords.begin();
+    for (int species_ix : species_order)
+    {
+        const std::string& name = species_name(distinct_species[species_ix]);
+        for (int site_count = 0; site_count < sites_of_species[species_ix].size(); ++site_count, ++frac_coord)
+        {
+            append_row(poscar_buffer, *frac_coord, align_columns);
+            poscar_buffer->push_back(' ');
+            poscar_buffer->append(name);
+            poscar_buffer->push_back('\n');
+        }
+    }
+    poscar_buffer->push_back('\n');
+    return;
+}
+
 void print_poscar(const Structure& printable, std::ostream& outstream)
 {
-    CASM::VaspIO::PrintPOSCAR p(printable.__get<CASM::xtal::SimpleStructure>());
-    p.sort();
-    p.print(outstream);
+    // The buffer is kept around so that printing many structures doesn't keep reallocating it
+    thread_local std::string poscar_buffer;
+    format_poscar(printable, &poscar_buffer);
+    outstream.write(poscar_buffer.data(), poscar_buffer.size());
     return;
 }
 
 void write_poscar(const Structure& printable, const fs::path& filename)
 {
-    std::ofstream file_out(filename.string());
-    print_poscar(printable, file_out);
+    thread_local std::string poscar_buffer;
+    format_poscar(printable, &poscar_buffer);
+
+    // Without a buffer on the file, the whole POSCAR goes out in a single write
+    std::ofstream file_out;
+    file_out.rdbuf()->pubsetbuf(nullptr, 0);
+    file_out.open(filename.string());
+    file_out.write(poscar_buffer.data(), poscar_buffer.size());
     file_out.close();
+    if (file_out.fail())
+    {
+        throw except::BadPath(filename);
+    }
     return;
 }
 
@@ -2,11 +2,14 @@
 #include <boost/program_options.hpp>
 #include <casmutils/definitions.hpp>
 #include <casmutils/handlers.hpp>
+#include <casmutils/mapping/structure_mapping.hpp>
+#include <casmutils/parallel.hpp>
 #include <casmutils/stage.hpp>
 #include <casmutils/xtal/structure_tools.hpp>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <optional>
 
 namespace utilities
 {
@@ -26,8 +29,45 @@ void struc_score_initializer(po::options_description& struc_score_desc)
     struc_score_desc.add_options()("weight,w",
                                    po::value<double>()->default_value(0.5),
                                    "Weight w in structure score: w*lattice_score + (1-w)*basis_score.");
+    struc_score_desc.add_options()(
+        "threads,j", po::value<int>()->default_value(0), "Number of threads to map with, 0 uses every core.");
+    struc_score_desc.add_options()("chunk,c",
+                                   po::value<std::size_t>()->default_value(1024),
+                                   "Number of batch file entries to read in at a time. Bounds the memory used. "
+                                   "The Structure column is as wide as the longest path in the first chunk, "
+                                   "longer paths after that push the rest of their row out of alignment.");
     return;
 }
+
+/// Outcome of scoring a single mappable structure
+struct ScoreRow
+{
+    fs::path path;
+    std::optional<std::pair<double, double>> lattice_basis_score;
+    std::string error;
+};
+
+/// Reads the structure at the path and scores its best map onto the reference
+ScoreRow score_structure(const casmutils::mapping::StructureMapper_f& mapper, const fs::path& mappable_path)
+{
+    ScoreRow row;
+    row.path = mappable_path;
+    try
+    {
+        auto reports = mapper(casmutils::xtal::Structure::from_poscar(mappable_path));
+        if (reports.empty())
+        {
+            row.error = "No valid map onto the reference structure";
+            return row;
+        }
+        row.lattice_basis_score = casmutils::mapping::structure_score(reports[0]);
+    }
+    catch (const std::exception& e)
+    {
+        row.error = e.what();
+    }
+    return row;
+}
 } // namespace utilities
 
 using namespace utilities;
@@ -54,78 +94,100 @@ int main(int argc, char* argv[])
         return 2;
     }
 
+    if (!struc_score_launch.count("mappable") && !struc_score_launch.count("batch"))
+    {
+        std::cout << "You must provide at least one structure to map." << std::endl;
+        return 2;
+    }
+
     auto reference_path = struc_score_launch.fetch<fs::path>("reference");
     auto map_reference_struc = xtal::Structure::from_poscar(reference_path);
     auto weight = struc_score_launch.fetch<double>("weight");
+    auto n_threads = struc_score_launch.fetch<int>("threads");
+    auto chunk_size = std::max<std::size_t>(1, struc_score_launch.fetch<std::size_t>("chunk"));
 
+    // Every thread maps onto the same reference, so the symmetry and the mapper only get prepared once
+    mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    mapping::StructureMapper_f mapper(map_reference_struc, input);
+
+    std::ostream* out_stream_ptr = &std::cout;
+    std::ofstream specified_out_stream;
+    if (struc_score_launch.count("output"))
+    {
+        auto out_path = struc_score_launch.fetch<fs::path>("output");
+        specified_out_stream.open(out_path.c_str());
+        if (!specified_out_stream.is_open())
+        {
+            std::cerr << "Could not open " << out_path.string() << " for writing." << std::endl;
+            return 3;
+        }
+        out_stream_ptr = &specified_out_stream;
+    }
+    auto& out_stream = *out_stream_ptr;
+
+    // The paths given on the command line go first, then the batch file is read one chunk at a time,
+    // so that only a chunk's worth of paths and results are ever held in memory
     std::vector<fs::path> mappable_paths;
     if (struc_score_launch.count("mappable"))
     {
         mappable_paths = struc_score_launch.fetch<std::vector<fs::path>>("mappable");
     }
-
+    std::optional<xtal::BatchFileReader> batch_reader;
     if (struc_score_launch.count("batch"))
     {
-        std::ifstream batch_file(struc_score_launch.fetch<fs::path>("batch").c_str());
-        std::string line;
-        while (std::getline(batch_file, line))
+        batch_reader.emplace(struc_score_launch.fetch<fs::path>("batch"));
+    }
+    auto next_chunk = [&]() {
+        if (mappable_paths.empty() && batch_reader)
         {
-            mappable_paths.push_back(fs::path(line));
+            mappable_paths = batch_reader->next(chunk_size);
         }
-    }
+        std::vector<fs::path> chunk;
+        chunk.swap(mappable_paths);
+        return chunk;
+    };
 
-    if (mappable_paths.empty())
+    // The whole batch can't be seen before writing, so the path column is sized by the first chunk (see --help)
+    std::vector<fs::path> chunk = next_chunk();
+    fs::path::string_type::size_type max_path_length = 0;
+    for (const fs::path& mappable_path : chunk)
     {
-        std::cout << "You must provide at least one structure to map." << std::endl;
-        return 2;
+        max_path_length = std::max(max_path_length, mappable_path.string().size());
     }
 
-    std::vector<xtal::Structure> mappable_strucs;
-    fs::path::string_type::size_type max_path_length = 0;
-    for (auto& path : mappable_paths)
+    out_stream << std::left << std::setw(max_path_length + 4) << "Structure";
+    out_stream << std::left << std::setw(16) << "Lattice";
+    out_stream << std::left << std::setw(16) << "Basis";
+    out_stream << std::left << std::setw(16) << "Weighted" << std::endl;
+
+    auto write_row = [&](std::size_t, ScoreRow row) {
+        if (!row.lattice_basis_score)
+        {
+            std::cerr << "Skipping " << row.path.string() << ": " << row.error << std::endl;
+            return;
+        }
+        auto [lat_score, basis_score] = *row.lattice_basis_score;
+        auto weighted_score = weight * lat_score + (1 - weight) * basis_score;
+
+        // Paths from later chunks can be longer than the column, but still need something between them and the score
+        out_stream << std::left << std::setw(max_path_length + 4) << row.path.string() + "  ";
+        out_stream << std::left << std::setw(16) << std::setprecision(8) << lat_score;
+        out_stream << std::left << std::setw(16) << std::setprecision(8) << basis_score;
+        out_stream << std::left << std::setw(16) << std::setprecision(8) << weighted_score << '\n';
+    };
+
+    for (; !chunk.empty(); chunk = next_chunk())
     {
-        mappable_strucs.push_back(xtal::Structure::from_poscar(path));
-        max_path_length = std::max(max_path_length, path.string().size());
+        // Rows are written in input order as soon as every row before them is done
+        parallel_for_ordered(
+            chunk.size(),
+            n_threads,
+            []() { return nullptr; },
+            [&mapper, &chunk](std::nullptr_t, std::size_t ix) { return score_structure(mapper, chunk[ix]); },
+            write_row);
+        out_stream.flush();
     }
-    throw except::NotImplemented();
-    // o all_scores = casmutils::xtal::structure_score(map_reference_struc, mappable_strucs);
-
-    // std::ostream* out_stream_ptr = &std::cout;
-    // std::ofstream specified_out_stream;
-    // if (struc_score_launch.count("output"))
-    //{
-    //    auto out_path = struc_score_launch.fetch<fs::path>("output");
-    //    specified_out_stream.open(out_path.c_str());
-    //    out_stream_ptr = &specified_out_stream;
-    //}
-    // auto& out_stream = *out_stream_ptr;
-
-    // out_stream << std::left << std::setw(max_path_length + 4) << "Structure";
-    // out_stream << std::left << std::setw(16) << "Lattice";
-    // out_stream << std::left << std::setw(16) << "Basis";
-    // out_stream << std::left << std::setw(16) << "Weighted" << std::endl;
-
-    // assert(all_scores.size() == mappable_paths.size());
-    // int path_ix = 0;
-    // for (const auto& lat_basis_score : all_scores)
-    //{
-    //    auto lat_score = lat_basis_score.first;
-    //    auto basis_score = lat_basis_score.second;
-    //    auto weighted_score = weight * lat_score + (1 - weight) * basis_score;
-
-    //    out_stream << std::left << std::setw(max_path_length + 4) << mappable_paths[path_ix].string();
-    //    out_stream << std::left << std::setw(16) << std::setprecision(8) << lat_score;
-    //    out_stream << std::left << std::setw(16) << std::setprecision(8) << basis_score;
-    //    out_stream << std::left << std::setw(16) << std::setprecision(8) << weighted_score << std::endl;
-
-    //    ++path_ix;
-    //}
-
-    //// why though
-    // if (struc_score_launch.count("output"))
-    //{
-    //    specified_out_stream.close();
-    //}
 
     return 0;
 }
@@ -2,6 +2,7 @@
 #include "../../../autotools.hh"
 #include "casmutils/xtal/site.hpp"
 #include <algorithm>
+#include <casm/crystallography/LatticeMap.hh>
 #include <casmutils/misc.hpp>
 #include <casmutils/xtal/structure.hpp>
 #include <casmutils/xtal/structure_tools.hpp>
@@ -15,7 +16,12 @@
 #include <limits>
 #include <math.h>
 #include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -83,6 +89,470 @@ TEST_F(StructureMapTest, DisplacementMappingScore)
     EXPECT_TRUE(std::abs(basis_score - 0.0327393) < 1e-5);
 }
 
+TEST_F(StructureMapTest, MapManyMatchesSingleMaps)
+{
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    input.k_best_maps = 2;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+
+    std::vector<Structure> mappable_strucs{*primitive_bcc_Ni_ptr,
+                                           *partial_bain_Ni_ptr,
+                                           *perfect_bain_Ni_ptr,
+                                           *displaced_fcc_Ni_ptr,
+                                           *primitive_fcc_Ni_ptr};
+    auto all_reports = map_to_fcc.map_many(mappable_strucs, 3);
+
+    ASSERT_EQ(all_reports.size(), mappable_strucs.size());
+    for (int i = 0; i < mappable_strucs.size(); ++i)
+    {
+        auto reports = map_to_fcc(mappable_strucs[i]);
+        ASSERT_EQ(all_reports[i].size(), reports.size());
+        for (int j = 0; j < reports.size(); ++j)
+        {
+            EXPECT_EQ(all_reports[i][j].cost, reports[j].cost);
+            EXPECT_TRUE(all_reports[i][j].stretch.isApprox(reports[j].stretch));
+            EXPECT_EQ(all_reports[i][j].permutation, reports[j].permutation);
+        }
+    }
+    EXPECT_TRUE(map_to_fcc.map_many({}).empty());
+}
+
+TEST_F(StructureMapTest, TryMapManyKeepsInvalidMaps)
+{
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    input.k_best_maps = 10;
+    input.keep_invalid_mapping_nodes = true;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+
+    std::vector<Structure> mappable_strucs{*primitive_bcc_Ni_ptr, *partial_bain_Ni_ptr, *displaced_fcc_Ni_ptr};
+    auto all_reports = map_to_fcc.map_many(mappable_strucs, 2);
+    auto all_results = map_to_fcc.try_map_many(mappable_strucs, 2);
+
+    ASSERT_EQ(all_results.size(), mappable_strucs.size());
+    for (int i = 0; i < mappable_strucs.size(); ++i)
+    {
+        ASSERT_TRUE(all_results[i].ok());
+        ASSERT_EQ(all_results[i].reports.size(), all_reports[i].size());
+        for (int j = 0; j < all_reports[i].size(); ++j)
+        {
+            const cu::mapping::MappingReport& report = all_results[i].reports[j];
+            EXPECT_EQ(report.cost, all_reports[i][j].cost);
+            EXPECT_EQ(report.valid, all_reports[i][j].valid);
+            // Invalid maps say why, valid ones don't
+            EXPECT_EQ(report.valid, report.reason.empty());
+
+            cu::mapping::CompactMappingReport compact_report(report);
+            EXPECT_EQ(compact_report.valid, report.valid);
+            EXPECT_EQ(cu::mapping::MappingReport(compact_report).reason, report.reason);
+        }
+    }
+    EXPECT_TRUE(map_to_fcc.try_map_many({}).empty());
+}
+
+TEST_F(StructureMapTest, ConcurrentCallsMatchSerial)
+{
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    input.k_best_maps = 3;
+    const cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+
+    std::vector<Structure> mappable_strucs{
+        *primitive_bcc_Ni_ptr, *partial_bain_Ni_ptr, *perfect_bain_Ni_ptr, *displaced_fcc_Ni_ptr};
+    std::vector<std::vector<cu::mapping::MappingReport>> serial_reports;
+    for (const Structure& struc : mappable_strucs)
+    {
+        serial_reports.push_back(map_to_fcc(struc));
+    }
+
+    // Every thread goes through all the structures several times, starting at a different one,
+    // so that the same structure gets mapped by many threads at once
+    const int n_threads = 32;
+    const int n_rounds = 4;
+    std::vector<std::vector<std::vector<cu::mapping::MappingReport>>> thread_reports(n_threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < n_threads; ++t)
+    {
+        pool.emplace_back([&, t]() {
+            for (int i = 0; i < n_rounds * mappable_strucs.size(); ++i)
+            {
+                thread_reports[t].push_back(map_to_fcc(mappable_strucs[(t + i) % mappable_strucs.size()]));
+            }
+        });
+    }
+    for (std::thread& thread : pool)
+    {
+        thread.join();
+    }
+
+    for (int t = 0; t < n_threads; ++t)
+    {
+        ASSERT_EQ(thread_reports[t].size(), n_rounds * mappable_strucs.size());
+        for (int i = 0; i < thread_reports[t].size(); ++i)
+        {
+            const auto& expected = serial_reports[(t + i) % mappable_strucs.size()];
+            const auto& reports = thread_reports[t][i];
+            ASSERT_EQ(reports.size(), expected.size());
+            for (int j = 0; j < reports.size(); ++j)
+            {
+                EXPECT_NEAR(reports[j].cost, expected[j].cost, 1e-10);
+                EXPECT_TRUE(reports[j].stretch.isApprox(expected[j].stretch, 1e-10));
+                EXPECT_TRUE(reports[j].isometry.isApprox(expected[j].isometry, 1e-10));
+                EXPECT_EQ(reports[j].permutation, expected[j].permutation);
+            }
+        }
+    }
+}
+
+TEST_F(StructureMapTest, RepeatedMapsComeFromCache)
+{
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    cu::mapping::StructureMapper_f uncached_map_to_fcc(*primitive_fcc_Ni_ptr, input);
+    input.cache_size = 2;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+
+    auto bcc_reports = map_to_fcc(*primitive_bcc_Ni_ptr);
+    // The same structure read again, e.g. from a resubmitted calculation
+    Structure resubmitted_bcc = *primitive_bcc_Ni_ptr;
+    auto cached_bcc_reports = map_to_fcc(resubmitted_bcc);
+    EXPECT_EQ(map_to_fcc.cache_hits(), 1);
+    EXPECT_EQ(map_to_fcc.cache_misses(), 1);
+
+    auto uncached_bcc_reports = uncached_map_to_fcc(*primitive_bcc_Ni_ptr);
+    ASSERT_EQ(cached_bcc_reports.size(), uncached_bcc_reports.size());
+    for (int i = 0; i < cached_bcc_reports.size(); ++i)
+    {
+        EXPECT_EQ(cached_bcc_reports[i].cost, uncached_bcc_reports[i].cost);
+        EXPECT_EQ(cached_bcc_reports[i].permutation, uncached_bcc_reports[i].permutation);
+    }
+    EXPECT_EQ(uncached_map_to_fcc.cache_hits(), 0);
+    EXPECT_EQ(uncached_map_to_fcc.cache_misses(), 0);
+
+    // Moving an atom by much less than the tolerance still makes a new structure, which must not get
+    // the reports of the old one
+    Structure nudged_bcc = *primitive_bcc_Ni_ptr;
+    nudged_bcc.set_cart(0, nudged_bcc.cart_coords().col(0) + Eigen::Vector3d(input.tol / 10, 0, 0));
+    auto nudged_bcc_reports = map_to_fcc(nudged_bcc);
+    EXPECT_EQ(map_to_fcc.cache_hits(), 1);
+    EXPECT_EQ(map_to_fcc.cache_misses(), 2);
+    auto uncached_nudged_bcc_reports = uncached_map_to_fcc(nudged_bcc);
+    ASSERT_EQ(nudged_bcc_reports.size(), uncached_nudged_bcc_reports.size());
+    for (int i = 0; i < nudged_bcc_reports.size(); ++i)
+    {
+        EXPECT_EQ(nudged_bcc_reports[i].cost, uncached_nudged_bcc_reports[i].cost);
+        EXPECT_EQ(nudged_bcc_reports[i].displacement, uncached_nudged_bcc_reports[i].displacement);
+    }
+
+    // Two new structures push bcc out of the cache
+    map_to_fcc(*partial_bain_Ni_ptr);
+    map_to_fcc(*displaced_fcc_Ni_ptr);
+    EXPECT_EQ(map_to_fcc.cache_size(), 2);
+    map_to_fcc(*primitive_bcc_Ni_ptr);
+    EXPECT_EQ(map_to_fcc.cache_hits(), 1);
+    EXPECT_EQ(map_to_fcc.cache_misses(), 5);
+}
+
+TEST_F(StructureMapTest, CollectsStats)
+{
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    cu::mapping::StructureMapper_f quiet_map_to_fcc(*primitive_fcc_Ni_ptr, input);
+    input.cache_size = 4;
+    input.collect_stats = true;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+    EXPECT_GT(map_to_fcc.stats().symmetry_seconds, 0);
+
+    std::vector<Structure> mappable_strucs{*primitive_bcc_Ni_ptr, *partial_bain_Ni_ptr, *displaced_fcc_Ni_ptr};
+    auto all_reports = map_to_fcc.map_many(mappable_strucs, 2);
+    map_to_fcc(*primitive_bcc_Ni_ptr);
+
+    std::size_t total_reports = all_reports[0].size() + all_reports[1].size() + all_reports[2].size();
+    cu::mapping::MappingStats stats = map_to_fcc.stats();
+    EXPECT_EQ(stats.structures, 4);
+    EXPECT_EQ(stats.cache_hits, 1);
+    EXPECT_EQ(stats.nodes_found, total_reports);
+    EXPECT_GE(stats.report_bytes, total_reports * sizeof(cu::mapping::MappingReport));
+    EXPECT_GT(stats.search_seconds, 0);
+
+    map_to_fcc.reset_stats();
+    EXPECT_EQ(map_to_fcc.stats().structures, 0);
+    EXPECT_EQ(map_to_fcc.stats().search_seconds, 0);
+
+    quiet_map_to_fcc.map_many(mappable_strucs, 2);
+    EXPECT_EQ(quiet_map_to_fcc.stats().structures, 0);
+    EXPECT_EQ(quiet_map_to_fcc.stats().search_seconds, 0);
+}
+
+TEST_F(StructureMapTest, KnownLatticeMatchesFullSearch)
+{
+    Structure fcc_superstructure =
+        cu::xtal::make_superstructure(*primitive_fcc_Ni_ptr, Eigen::Matrix3i(3 * Eigen::Matrix3i::Identity()));
+    Structure relaxed_superstructure = fcc_superstructure;
+    relaxed_superstructure.set_cart(4, relaxed_superstructure.cart_coords().col(4) + Eigen::Vector3d(0.05, 0, 0.02));
+    relaxed_superstructure.set_cart(11, relaxed_superstructure.cart_coords().col(11) + Eigen::Vector3d(0, -0.03, 0));
+
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    auto full_reports = cu::mapping::StructureMapper_f(*primitive_fcc_Ni_ptr, input)(relaxed_superstructure);
+    auto imposed_full_reports = cu::mapping::StructureMapper_f(fcc_superstructure, input)(relaxed_superstructure);
+
+    input.assume_ideal_lattice = true;
+    cu::mapping::StructureMapper_f map_onto_ideal_lattice(*primitive_fcc_Ni_ptr, input);
+    auto ideal_lattice_reports = map_onto_ideal_lattice(relaxed_superstructure);
+    // bcc isn't a supercell of fcc, so there's nothing to map onto
+    EXPECT_THROW(map_onto_ideal_lattice(*primitive_bcc_Ni_ptr), except::UserInputMangle);
+    // Asking whether it's equivalent has a plain answer though
+    EXPECT_FALSE(map_onto_ideal_lattice.is_equivalent(*primitive_bcc_Ni_ptr));
+    EXPECT_TRUE(map_onto_ideal_lattice.is_equivalent(fcc_superstructure));
+    // Scaling doesn't change the fingerprint, but the scaled lattice isn't a supercell of the reference any more
+    Structure scaled_superstructure =
+        cu::xtal::apply_deformation(fcc_superstructure, Eigen::Matrix3d(1.1 * Eigen::Matrix3d::Identity()));
+    EXPECT_FALSE(map_onto_ideal_lattice.is_equivalent(scaled_superstructure));
+
+    // Rotating the whole structure, or turning it by an operation of the point group, leaves the same supercell
+    Eigen::Matrix3d arbitrary_rotation = Eigen::AngleAxisd(0.7, Eigen::Vector3d(1, 2, 3).normalized()).matrix();
+    Eigen::Matrix3d quarter_turn = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitZ()).matrix();
+    for (const Eigen::Matrix3d& rotation : {arbitrary_rotation, quarter_turn})
+    {
+        Structure rotated_superstructure = cu::xtal::apply_deformation(relaxed_superstructure, rotation);
+        auto rotated_reports = map_onto_ideal_lattice(rotated_superstructure);
+        ASSERT_FALSE(rotated_reports.empty());
+        EXPECT_NEAR(rotated_reports[0].cost, full_reports[0].cost, 1e-8);
+        EXPECT_NEAR(rotated_reports[0].basis_cost, full_reports[0].basis_cost, 1e-8);
+    }
+
+    input.assume_ideal_lattice = false;
+    input.impose_reference_lattice = true;
+    auto imposed_reports = cu::mapping::StructureMapper_f(fcc_superstructure, input)(relaxed_superstructure);
+
+    ASSERT_FALSE(full_reports.empty());
+    ASSERT_FALSE(imposed_full_reports.empty());
+    ASSERT_FALSE(ideal_lattice_reports.empty());
+    ASSERT_FALSE(imposed_reports.empty());
+    EXPECT_NEAR(ideal_lattice_reports[0].cost, full_reports[0].cost, 1e-8);
+    EXPECT_NEAR(ideal_lattice_reports[0].basis_cost, full_reports[0].basis_cost, 1e-8);
+    EXPECT_NEAR(imposed_reports[0].cost, imposed_full_reports[0].cost, 1e-8);
+    EXPECT_NEAR(imposed_reports[0].basis_cost, imposed_full_reports[0].basis_cost, 1e-8);
+}
+
+TEST_F(StructureMapTest, IsEquivalent)
+{
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    input.min_cost = 1e-8;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+
+    EXPECT_TRUE(map_to_fcc.is_equivalent(*primitive_fcc_Ni_ptr));
+    EXPECT_FALSE(map_to_fcc.is_equivalent(*primitive_bcc_Ni_ptr));
+    EXPECT_FALSE(map_to_fcc.is_equivalent(*partial_bain_Ni_ptr));
+    EXPECT_FALSE(map_to_fcc.is_equivalent(*displaced_fcc_Ni_ptr));
+
+    // Any supercell of the reference is still the same structure
+    Eigen::Matrix3i transformation;
+    transformation << 1, 1, 0, -1, 1, 0, 0, 0, 2;
+    Structure super_fcc = cu::xtal::make_superstructure(*primitive_fcc_Ni_ptr, transformation);
+    EXPECT_TRUE(map_to_fcc.is_equivalent(super_fcc));
+
+    // A different species never maps
+    Structure fcc_Cu = *primitive_fcc_Ni_ptr;
+    fcc_Cu.set_species(0, "Cu");
+    EXPECT_FALSE(map_to_fcc.is_equivalent(fcc_Cu));
+
+    // The yes or no answer agrees with asking for every map below min_cost
+    input.k_best_maps = 0;
+    cu::mapping::StructureMapper_f full_map_to_fcc(*primitive_fcc_Ni_ptr, input);
+    for (const Structure* struc : {primitive_bcc_Ni_ptr.get(), displaced_fcc_Ni_ptr.get(), &super_fcc})
+    {
+        EXPECT_EQ(map_to_fcc.is_equivalent(*struc), !full_map_to_fcc(*struc).empty());
+    }
+
+    cu::mapping::StructureEquals_f structures_are_equal(input);
+    EXPECT_TRUE(structures_are_equal(*primitive_fcc_Ni_ptr, super_fcc));
+    EXPECT_FALSE(structures_are_equal(*primitive_fcc_Ni_ptr, *primitive_bcc_Ni_ptr));
+}
+
+TEST_F(StructureMapTest, IsEquivalentWithStrain)
+{
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    input.min_cost = 1e-4;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+    input.k_best_maps = 0;
+    cu::mapping::StructureMapper_f full_map_to_fcc(*primitive_fcc_Ni_ptr, input);
+
+    // Stretch along x and squeeze along y, until the lattice part of the cost is the given fraction of min_cost
+    auto strained_to = [&](const Structure& struc, double cost_fraction) {
+        double stretch = 0.01;
+        Eigen::Matrix3d deformation;
+        for (int iteration = 0; iteration < 20; ++iteration)
+        {
+            deformation = Eigen::Vector3d(1 + stretch, 1 / (1 + stretch), 1).asDiagonal();
+            double cost =
+                input.strain_weight * CASM::xtal::StrainCostCalculator::isotropic_strain_cost(deformation);
+            stretch *= std::sqrt(cost_fraction * input.min_cost / cost);
+        }
+        return cu::xtal::apply_deformation(struc, deformation);
+    };
+
+    Eigen::Matrix3i transformation;
+    transformation << 1, 1, 0, -1, 1, 0, 0, 0, 2;
+    Structure super_fcc = cu::xtal::make_superstructure(*primitive_fcc_Ni_ptr, transformation);
+    Structure scaled_fcc =
+        cu::xtal::apply_deformation(*primitive_fcc_Ni_ptr, Eigen::Matrix3d(1.2 * Eigen::Matrix3d::Identity()));
+
+    Structure barely_strained_fcc = strained_to(*primitive_fcc_Ni_ptr, 0.9);
+    EXPECT_TRUE(map_to_fcc.is_equivalent(barely_strained_fcc));
+
+    // Neither the volume nor the size of the supercell is allowed to rule anything out early
+    for (const Structure& struc : {barely_strained_fcc,
+                                   strained_to(*primitive_fcc_Ni_ptr, 1.1),
+                                   strained_to(super_fcc, 0.9),
+                                   strained_to(super_fcc, 1.1),
+                                   scaled_fcc})
+    {
+        EXPECT_EQ(map_to_fcc.is_equivalent(struc), !full_map_to_fcc(struc).empty());
+    }
+}
+
+TEST_F(StructureMapTest, EnumerateMatchesKBest)
+{
+    cu::mapping::MappingInput input;
+    input.k_best_maps = 6;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+    auto k_best_reports = map_to_fcc(*partial_bain_Ni_ptr);
+    ASSERT_GE(k_best_reports.size(), input.k_best_maps);
+
+    cu::mapping::MappingEnumerator enumerator = map_to_fcc.enumerate(*partial_bain_Ni_ptr);
+    double last_cost = -1;
+    for (int i = 0; i < input.k_best_maps; ++i)
+    {
+        std::optional<cu::mapping::MappingReport> report = enumerator.next();
+        ASSERT_TRUE(report.has_value());
+        EXPECT_NEAR(report->cost, k_best_reports[i].cost, 1e-10);
+        EXPECT_GE(report->cost, last_cost - 1e-10);
+        last_cost = report->cost;
+    }
+}
+
+TEST_F(StructureMapTest, EnumerateRunsOut)
+{
+    cu::mapping::MappingInput input;
+    input.max_cost = 1e-8;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+
+    // Only the perfect self maps are within max_cost, one for every operation of the point group
+    cu::mapping::MappingEnumerator enumerator = map_to_fcc.enumerate(*primitive_fcc_Ni_ptr);
+    int n_maps = 0;
+    while (auto report = enumerator.next())
+    {
+        EXPECT_LE(report->cost, input.max_cost);
+        ++n_maps;
+    }
+    EXPECT_EQ(n_maps, 48);
+    EXPECT_FALSE(enumerator.next().has_value());
+    EXPECT_FALSE(map_to_fcc.enumerate(*primitive_bcc_Ni_ptr).next().has_value());
+}
+
+TEST_F(StructureMapTest, CompactReportsMatchFull)
+{
+    cu::mapping::MappingInput input;
+    input.k_best_maps = 4;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+    auto reports = map_to_fcc(*partial_bain_Ni_ptr);
+    auto compact_reports = map_to_fcc.map_compact(*partial_bain_Ni_ptr);
+    ASSERT_EQ(reports.size(), compact_reports.size());
+
+    for (int i = 0; i < reports.size(); ++i)
+    {
+        cu::mapping::MappingReport expanded(compact_reports[i]);
+        for (const cu::mapping::MappingReport& report : {reports[i], expanded})
+        {
+            EXPECT_TRUE(report.isometry.isApprox(compact_reports[i].isometry));
+            EXPECT_TRUE(report.stretch.isApprox(compact_reports[i].stretch));
+            EXPECT_TRUE(report.translation.isApprox(compact_reports[i].translation));
+            EXPECT_TRUE(report.displacement.isApprox(compact_reports[i].displacement));
+            EXPECT_TRUE(std::equal(report.permutation.begin(),
+                                   report.permutation.end(),
+                                   compact_reports[i].permutation.begin(),
+                                   compact_reports[i].permutation.end()));
+            EXPECT_EQ(report.cost, compact_reports[i].cost);
+            EXPECT_TRUE(
+                report.reference_lattice.column_vector_matrix().isApprox(compact_reports[i].reference_lattice));
+            EXPECT_TRUE(report.mapped_lattice.column_vector_matrix().isApprox(compact_reports[i].mapped_lattice));
+        }
+        EXPECT_EQ(cu::mapping::structure_score(reports[i]), cu::mapping::structure_score(expanded));
+    }
+
+    cu::mapping::CompactMappingReport shrunk(reports[0]);
+    EXPECT_TRUE(shrunk.displacement.isApprox(compact_reports[0].displacement));
+    EXPECT_LT(sizeof(cu::mapping::CompactMappingReport), sizeof(cu::mapping::MappingReport));
+}
+
+TEST_F(StructureMapTest, SaveAndLoad)
+{
+    cu::fs::path prepared_path = cu::autotools::output_filesdir / "prepared_fcc_mapper.json";
+    cu::fs::remove(prepared_path);
+
+    cu::mapping::MappingInput input;
+    input.use_crystal_symmetry = true;
+    input.k_best_maps = 3;
+    input.strain_weight = 0.3;
+    input.cache_size = 16;
+    input.collect_stats = true;
+    cu::mapping::StructureMapper_f map_to_fcc(*primitive_fcc_Ni_ptr, input);
+    map_to_fcc.save(prepared_path);
+
+    // Settings that only matter at runtime aren't part of what gets saved
+    std::stringstream prepared_text;
+    prepared_text << std::ifstream(prepared_path).rdbuf();
+    EXPECT_EQ(prepared_text.str().find("cache_size"), std::string::npos);
+    EXPECT_EQ(prepared_text.str().find("collect_stats"), std::string::npos);
+
+    cu::mapping::StructureMapper_f loaded_map_to_fcc = cu::mapping::StructureMapper_f::load(prepared_path);
+    for (const Structure* mappable : {partial_bain_Ni_ptr.get(), displaced_fcc_Ni_ptr.get()})
+    {
+        auto reports = map_to_fcc(*mappable);
+        auto loaded_reports = loaded_map_to_fcc(*mappable);
+        ASSERT_EQ(reports.size(), loaded_reports.size());
+        for (int i = 0; i < reports.size(); ++i)
+        {
+            EXPECT_EQ(reports[i].cost, loaded_reports[i].cost);
+            EXPECT_TRUE(reports[i].displacement == loaded_reports[i].displacement);
+            EXPECT_EQ(reports[i].permutation, loaded_reports[i].permutation);
+        }
+    }
+
+    std::ofstream(prepared_path) << "{\"format\": \"something else\"}";
+    EXPECT_THROW(cu::mapping::StructureMapper_f::load(prepared_path), except::BadPreparedMapper);
+    cu::fs::remove(prepared_path);
+}
+
+TEST_F(StructureMapTest, MapStructureWithCacheDir)
+{
+    cu::fs::path cache_dir = cu::autotools::output_filesdir / "prepared_mapper_cache";
+    cu::fs::remove_all(cache_dir);
+
+    auto reports = cu::mapping::map_structure(*primitive_fcc_Ni_ptr, *partial_bain_Ni_ptr);
+    for (int run = 0; run < 2; ++run)
+    {
+        auto cached_reports = cu::mapping::map_structure(*primitive_fcc_Ni_ptr, *partial_bain_Ni_ptr, cache_dir);
+        ASSERT_EQ(reports.size(), cached_reports.size());
+        EXPECT_EQ(reports[0].cost, cached_reports[0].cost);
+        EXPECT_EQ(std::distance(cu::fs::directory_iterator(cache_dir), cu::fs::directory_iterator()), 1);
+    }
+    // The name comes from a fixed hash, so that every build finds the same file
+    std::string prepared_name = cu::fs::directory_iterator(cache_dir)->path().filename().string();
+    EXPECT_EQ(prepared_name.size(), std::string("prepared_mapper_.json").size() + 16);
+    EXPECT_EQ(prepared_name.rfind("prepared_mapper_", 0), 0);
+
+    // A different reference gets a file of its own
+    cu::mapping::map_structure(*primitive_bcc_Ni_ptr, *partial_bain_Ni_ptr, cache_dir);
+    EXPECT_EQ(std::distance(cu::fs::directory_iterator(cache_dir), cu::fs::directory_iterator()), 2);
+    cu::fs::remove_all(cache_dir);
+}
+
 class SymmetryPreservingMappingTest : public testing::Test
 {
 protected:
@@ -167,6 +637,91 @@ TEST_F(SymmetryPreservingMappingTest, NotPreservingTest)
     Eigen::Matrix3d ident = Eigen::Matrix3d::Identity() * scale_factor;
     EXPECT_TRUE(cu::almost_equal(ident, adjusted_report.stretch, 1e-5));
 }
+
+/// The original implementation of symmetry_preserving_mapping_report, kept to make sure that
+/// the faster one gives exactly the same results
+cu::mapping::MappingReport
+reference_symmetry_preserving_report(const cu::mapping::MappingReport& mapping_data,
+                                     const std::vector<cu::sym::CartOp>& group_as_operations,
+                                     const std::vector<cu::sym::PermRep>& group_as_permutations)
+{
+    const auto disp_matrix = mapping_data.displacement;
+    auto symmetry_preserving_displacement = disp_matrix;
+    auto symmetry_preserving_stretch = mapping_data.stretch;
+    symmetry_preserving_displacement.setZero();
+    symmetry_preserving_stretch.setZero();
+    for (int i = 0; i < group_as_operations.size(); ++i)
+    {
+        auto transformed_disp = group_as_operations[i].matrix * disp_matrix;
+        Eigen::MatrixXd transformed_and_permuted_disp = transformed_disp;
+        transformed_and_permuted_disp.setZero();
+        int ind = 0;
+        for (const auto& j : group_as_permutations[i])
+        {
+            transformed_and_permuted_disp.col(j) += transformed_disp.col(ind);
+            ind++;
+        }
+        symmetry_preserving_displacement += transformed_and_permuted_disp / group_as_operations.size();
+        Eigen::MatrixXd transformed_stretch =
+            group_as_operations[i].matrix.transpose() * mapping_data.stretch * group_as_operations[i].matrix;
+        symmetry_preserving_stretch += transformed_stretch / group_as_operations.size();
+    }
+    auto new_report = mapping_data;
+    new_report.stretch = symmetry_preserving_stretch;
+    new_report.displacement = symmetry_preserving_displacement;
+    return new_report;
+}
+
+TEST_F(SymmetryPreservingMappingTest, MatchesReferenceBitForBit)
+{
+    cu::mapping::MappingReport full_report =
+        cu::mapping::map_structure(*conventional_fcc_Ni_ptr, *partial_bain_Ni_ptr)[0];
+    auto fcc_group = cu::xtal::make_factor_group(*conventional_fcc_Ni_ptr, tol);
+
+    // Scramble the sites with arbitrary permutations and displacements, so that every bit of the
+    // arithmetic gets exercised, including the columns that are exactly zero
+    std::mt19937 generator(2020);
+    std::vector<cu::mapping::MappingReport> scrambled_reports;
+    std::vector<cu::sym::PermRep> perm_group(fcc_group.size());
+    for (int n_sites : {1, 2, 5, 37})
+    {
+        for (cu::sym::PermRep& perm : perm_group)
+        {
+            perm.resize(n_sites);
+            std::iota(perm.begin(), perm.end(), 0);
+            std::shuffle(perm.begin(), perm.end(), generator);
+        }
+
+        scrambled_reports.clear();
+        for (int i = 0; i < 6; ++i)
+        {
+            cu::mapping::MappingReport scrambled = full_report;
+            scrambled.displacement = 0.1 * Eigen::MatrixXd::Random(3, n_sites);
+            scrambled.displacement.col(0).setZero();
+            scrambled.stretch = full_report.stretch + 0.01 * Eigen::Matrix3d::Random();
+            scrambled_reports.push_back(scrambled);
+        }
+
+        auto batched_reports =
+            cu::mapping::symmetry_preserving_mapping_reports(scrambled_reports, fcc_group, perm_group, 3);
+        ASSERT_EQ(batched_reports.size(), scrambled_reports.size());
+        for (int i = 0; i < scrambled_reports.size(); ++i)
+        {
+            auto reference = reference_symmetry_preserving_report(scrambled_reports[i], fcc_group, perm_group);
+            auto single = cu::mapping::symmetry_preserving_mapping_report(scrambled_reports[i], fcc_group, perm_group);
+            for (const cu::mapping::MappingReport& report : {single, batched_reports[i]})
+            {
+                EXPECT_TRUE(report.displacement == reference.displacement);
+                EXPECT_TRUE(report.stretch == reference.stretch);
+                EXPECT_EQ(report.cost, reference.cost);
+            }
+        }
+    }
+
+    perm_group.pop_back();
+    EXPECT_THROW(cu::mapping::symmetry_preserving_mapping_report(full_report, fcc_group, perm_group),
+                 except::UserInputMangle);
+}
 //**********************************************************************************************
 
 // TODO: Move this somewhere common because it's useful
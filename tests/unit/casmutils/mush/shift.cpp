@@ -225,6 +225,32 @@ TEST_F(ShiftingTest, CategorizeShifts)
     }
 }
 
+TEST_F(ShiftingTest, CategorizeShiftsMatchesAllPairs)
+{
+    auto index_map = cu::mush::categorize_equivalently_shifted_structures(shifted_structures);
+
+    // Map every structure onto every other one, which is what categorizing used to do
+    cu::mapping::MappingInput map_strategy;
+    map_strategy.k_best_maps = 0;
+    map_strategy.min_cost = 1e-8;
+    map_strategy.use_crystal_symmetry = true;
+
+    ASSERT_EQ(index_map.size(), shifted_structures.size());
+    for (int i = 0; i < shifted_structures.size(); ++i)
+    {
+        cu::mapping::StructureMapper_f map_to_shifted(shifted_structures[i], map_strategy);
+        std::vector<std::size_t> equivalent_indexes;
+        for (int s_ix = 0; s_ix < shifted_structures.size(); ++s_ix)
+        {
+            if (map_to_shifted(shifted_structures[s_ix]).size() > 0)
+            {
+                equivalent_indexes.push_back(s_ix);
+            }
+        }
+        EXPECT_EQ(index_map[i], equivalent_indexes);
+    }
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
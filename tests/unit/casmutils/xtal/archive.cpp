@@ -0,0 +1,259 @@
+// These are classes that archive depends on
+#include "../../../autotools.hh"
+#include <casmutils/definitions.hpp>
+#include <casmutils/exceptions.hpp>
+#include <casmutils/misc.hpp>
+#include <casmutils/xtal/lattice.hpp>
+#include <casmutils/xtal/site.hpp>
+#include <casmutils/xtal/structure.hpp>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <stdexcept>
+// This file tests the functions in:
+#include <casmutils/xtal/archive.hpp>
+
+namespace cu = casmutils;
+
+class ArchiveTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        archive_path = cu::autotools::output_filesdir / "test_archive.cus";
+        poscar_path = cu::autotools::output_filesdir / "archive_export.vasp";
+        cu::fs::remove(archive_path);
+
+        cu::xtal::Lattice cubic_lat(Eigen::Vector3d(2, 0, 0), Eigen::Vector3d(0, 2, 0), Eigen::Vector3d(0, 0, 2));
+        cu::xtal::Lattice tall_lat(Eigen::Vector3d(2, 0, 0), Eigen::Vector3d(0, 2, 0), Eigen::Vector3d(0.5, 0, 7));
+
+        structures.emplace_back(cubic_lat,
+                                std::vector<cu::xtal::Site>{cu::xtal::Site(Eigen::Vector3d(0, 0, 0), "Ni"),
+                                                            cu::xtal::Site(Eigen::Vector3d(1, 1, 1), "O")});
+        structures.emplace_back(tall_lat,
+                                std::vector<cu::xtal::Site>{cu::xtal::Site(Eigen::Vector3d(0.1, 0.2, 0.3), "Mg"),
+                                                            cu::xtal::Site(Eigen::Vector3d(1, 0, 3.5), "Mg"),
+                                                            cu::xtal::Site(Eigen::Vector3d(1, 1, 5), "Ni")});
+        structures.emplace_back(cubic_lat, std::vector<cu::xtal::Site>{cu::xtal::Site(Eigen::Vector3d(1, 0, 1), "O")});
+    }
+
+    void TearDown() override
+    {
+        cu::fs::remove(archive_path);
+        cu::fs::remove(poscar_path);
+    }
+
+    /// Everything in the output directory that starts with the name of the archive
+    std::vector<cu::fs::path> files_next_to_archive()
+    {
+        std::vector<cu::fs::path> files;
+        for (const cu::fs::directory_entry& entry : cu::fs::directory_iterator(archive_path.parent_path()))
+        {
+            if (entry.path().filename().string().rfind(archive_path.filename().string(), 0) == 0)
+            {
+                files.push_back(entry.path());
+            }
+        }
+        return files;
+    }
+
+    bool structures_are_identical(const cu::xtal::Structure& ref, const cu::xtal::Structure& other)
+    {
+        return ref.lattice().column_vector_matrix() == other.lattice().column_vector_matrix() &&
+               ref.cart_coords() == other.cart_coords() && ref.species_ids() == other.species_ids();
+    }
+
+    cu::fs::path archive_path;
+    cu::fs::path poscar_path;
+    std::vector<cu::xtal::Structure> structures;
+};
+
+TEST_F(ArchiveTest, WriteAndRead)
+{
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        writer.append("shift_0/cleave_0", structures[0], {{"shift_a", 0}, {"shift_b", 0}, {"cleavage", 0.0}});
+        writer.append("shift_1/cleave_0", structures[1], {{"shift_a", 1}, {"shift_b", 0}, {"cleavage", 0.5}});
+        EXPECT_THROW(writer.append("shift_1/cleave_0", structures[2]), except::UserInputMangle);
+        writer.close();
+    }
+
+    cu::xtal::StructureArchiveReader reader(archive_path);
+    ASSERT_EQ(reader.size(), 2);
+    EXPECT_EQ(reader.keys(), std::vector<std::string>({"shift_0/cleave_0", "shift_1/cleave_0"}));
+    EXPECT_TRUE(reader.contains("shift_1/cleave_0"));
+    EXPECT_FALSE(reader.contains("shift_2/cleave_0"));
+
+    // Coordinates are stored as they are, so the structures come back bit for bit
+    EXPECT_TRUE(structures_are_identical(structures[0], reader.structure("shift_0/cleave_0")));
+    EXPECT_TRUE(structures_are_identical(structures[1], reader.structure(1)));
+    EXPECT_EQ(reader.metadata("shift_1/cleave_0").at("shift_a"), 1);
+    EXPECT_EQ(reader.metadata("shift_1/cleave_0").at("cleavage"), 0.5);
+
+    EXPECT_EQ(reader.species_names().size(), 3);
+    EXPECT_EQ(reader.lattices().size(), 2);
+    EXPECT_THROW(reader.structure("shift_2/cleave_0"), std::out_of_range);
+    EXPECT_THROW(reader.structure(2), std::out_of_range);
+}
+
+TEST_F(ArchiveTest, AppendToExisting)
+{
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        writer.append("first", structures[0]);
+        writer.append("second", structures[1]);
+        writer.close();
+    }
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        EXPECT_EQ(writer.size(), 2);
+        writer.append("third", structures[2], {{"moire_size", 13}});
+        writer.close();
+    }
+
+    cu::xtal::StructureArchiveReader reader(archive_path);
+    ASSERT_EQ(reader.size(), 3);
+    for (int i = 0; i < structures.size(); ++i)
+    {
+        EXPECT_TRUE(structures_are_identical(structures[i], reader.structure(i)));
+    }
+    EXPECT_EQ(reader.metadata("third").at("moire_size"), 13);
+    // The third structure shares its lattice and species with the first
+    EXPECT_EQ(reader.lattices().size(), 2);
+    EXPECT_EQ(reader.species_names().size(), 3);
+}
+
+TEST_F(ArchiveTest, ArchiveIntactUntilClosed)
+{
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        writer.append("first", structures[0]);
+        writer.close();
+    }
+
+    cu::xtal::StructureArchiveWriter writer(archive_path);
+    writer.append("second", structures[1]);
+    // If the program died here, the archive would still have everything it had before
+    EXPECT_EQ(cu::xtal::StructureArchiveReader(archive_path).keys(), std::vector<std::string>({"first"}));
+    writer.close();
+
+    cu::xtal::StructureArchiveReader reader(archive_path);
+    EXPECT_EQ(reader.keys(), std::vector<std::string>({"first", "second"}));
+    EXPECT_TRUE(files_next_to_archive() == std::vector<cu::fs::path>{archive_path});
+
+    cu::fs::path unwritable_path = cu::autotools::output_filesdir / "no_such_dir" / "archive.cus";
+    EXPECT_THROW(cu::xtal::StructureArchiveWriter unwritable_writer(unwritable_path), except::BadPath);
+}
+
+TEST_F(ArchiveTest, DiscardedWithoutClose)
+{
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        writer.append("first", structures[0]);
+        writer.close();
+    }
+
+    try
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        writer.append("second", structures[1]);
+        throw std::runtime_error("the enumeration failed halfway through");
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        writer.append("third", structures[2]);
+    }
+
+    // Neither writer was closed, so the archive still only has the first structure
+    EXPECT_EQ(cu::xtal::StructureArchiveReader(archive_path).keys(), std::vector<std::string>({"first"}));
+    EXPECT_TRUE(files_next_to_archive() == std::vector<cu::fs::path>{archive_path});
+
+    // Two writers don't get in each other's way, the last one to close wins
+    cu::xtal::StructureArchiveWriter writer(archive_path);
+    cu::xtal::StructureArchiveWriter other_writer(archive_path);
+    writer.append("second", structures[1]);
+    other_writer.append("third", structures[2]);
+    writer.close();
+    EXPECT_EQ(cu::xtal::StructureArchiveReader(archive_path).keys(), std::vector<std::string>({"first", "second"}));
+    other_writer.close();
+    EXPECT_EQ(cu::xtal::StructureArchiveReader(archive_path).keys(), std::vector<std::string>({"first", "third"}));
+}
+
+TEST_F(ArchiveTest, ExportPOSCAR)
+{
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        writer.append("mg", structures[1]);
+        writer.close();
+    }
+    cu::xtal::StructureArchiveReader reader(archive_path);
+    reader.export_poscar("mg", poscar_path);
+
+    cu::xtal::Structure exported = cu::xtal::Structure::from_poscar(poscar_path);
+    EXPECT_TRUE(cu::is_equal<cu::xtal::LatticeEquals_f>(structures[1].lattice(), exported.lattice(), 1e-6));
+    ASSERT_EQ(exported.basis_sites().size(), structures[1].basis_sites().size());
+    for (int i = 0; i < exported.basis_sites().size(); ++i)
+    {
+        EXPECT_TRUE(cu::is_equal<cu::xtal::SiteEquals_f>(
+            structures[1].basis_sites()[i], exported.basis_sites()[i], 1e-6));
+    }
+}
+
+TEST_F(ArchiveTest, UnfinishedArchive)
+{
+    {
+        std::ofstream not_an_archive(archive_path);
+        not_an_archive << "Ni\n1.0\n2 0 0\n0 2 0\n0 0 2\nNi\n1\nDirect\n0 0 0\n";
+    }
+    EXPECT_THROW(cu::xtal::StructureArchiveReader reader(archive_path), except::BadArchive);
+}
+
+TEST_F(ArchiveTest, CorruptArchive)
+{
+    {
+        cu::xtal::StructureArchiveWriter writer(archive_path);
+        writer.append("corrupt", structures[1]);
+        writer.close();
+    }
+    std::string archive_bytes;
+    {
+        std::ifstream archive_file(archive_path, std::ios::binary);
+        archive_bytes.assign(std::istreambuf_iterator<char>(archive_file), std::istreambuf_iterator<char>());
+    }
+    auto write_archive = [this](const std::string& bytes) {
+        std::ofstream archive_file(archive_path, std::ios::binary | std::ios::trunc);
+        archive_file.write(bytes.data(), bytes.size());
+    };
+
+    std::string bad_magic = archive_bytes;
+    bad_magic[0] = 'X';
+    write_archive(bad_magic);
+    EXPECT_THROW(cu::xtal::StructureArchiveReader reader(archive_path), except::BadArchive);
+
+    write_archive(archive_bytes.substr(0, 6));
+    EXPECT_THROW(cu::xtal::StructureArchiveReader reader(archive_path), except::BadArchive);
+
+    write_archive(archive_bytes.substr(0, archive_bytes.size() - 1));
+    EXPECT_THROW(cu::xtal::StructureArchiveReader reader(archive_path), except::BadArchive);
+
+    // The site count comes right after the key and the offset of the block in the index. A count this
+    // large overflows if it's multiplied by the size of a site, which would make it look like it fits.
+    std::size_t site_count_position = archive_bytes.rfind("corrupt") + std::string("corrupt").size() + 8;
+    std::string bad_site_count = archive_bytes;
+    std::uint64_t huge_site_count = (std::uint64_t(1) << 62) + 1;
+    std::memcpy(&bad_site_count[site_count_position], &huge_site_count, sizeof(huge_site_count));
+    write_archive(bad_site_count);
+    EXPECT_THROW(cu::xtal::StructureArchiveReader reader(archive_path), except::BadArchive);
+
+    write_archive(archive_bytes);
+    EXPECT_EQ(cu::xtal::StructureArchiveReader(archive_path).size(), 1);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -77,6 +77,33 @@ TEST_F(CoordinateTest, WignerSeitzWithin)
     EXPECT_TRUE(casmutils::is_equal<CoordinateEquals_f>(new_far_far_right, ws_within, tol));
 }
 
+TEST_F(CoordinateTest, BatchedConversions)
+{
+    // every column of the batched conversion should match converting them one at a time
+    Eigen::Matrix3Xd cart_coords(3, 4);
+    cart_coords << 0.1, -1.3, 2.7, 0.25, 0.2, 0.8, -0.4, 0.25, 0.3, 1.9, 0.1, 0.0;
+
+    Eigen::Matrix3Xd batch_frac = casmutils::xtal::cartesian_to_fractional_batch(cart_coords, *fcc_lattice_ptr);
+    Eigen::Matrix3Xd batch_cart = casmutils::xtal::fractional_to_cartesian_batch(batch_frac, *fcc_lattice_ptr);
+    Eigen::Matrix3Xd batch_within = casmutils::xtal::bring_within_lattice_batch(cart_coords, *fcc_lattice_ptr);
+    Eigen::Matrix3Xd batch_ws = casmutils::xtal::bring_within_wigner_seitz_batch(cart_coords, *fcc_lattice_ptr);
+    ASSERT_EQ(batch_frac.cols(), cart_coords.cols());
+
+    CoordinateEquals_f coords_equal(tol);
+    for (int i = 0; i < cart_coords.cols(); ++i)
+    {
+        Eigen::Vector3d cart_coord = cart_coords.col(i);
+        Eigen::Vector3d frac_coord = casmutils::xtal::cartesian_to_fractional(cart_coord, *fcc_lattice_ptr);
+        Eigen::Vector3d within_coord = casmutils::xtal::bring_within_lattice(cart_coord, *fcc_lattice_ptr);
+        Eigen::Vector3d ws_coord = casmutils::xtal::bring_within_wigner_seitz(cart_coord, *fcc_lattice_ptr);
+
+        EXPECT_TRUE(coords_equal(frac_coord, batch_frac.col(i)));
+        EXPECT_TRUE(coords_equal(cart_coord, batch_cart.col(i)));
+        EXPECT_TRUE(coords_equal(within_coord, batch_within.col(i)));
+        EXPECT_TRUE(coords_equal(ws_coord, batch_ws.col(i)));
+    }
+}
+
 TEST_F(CoordinateTest, CoordinateEquals)
 {
     CoordinateEquals_f coord0_equals(tol);
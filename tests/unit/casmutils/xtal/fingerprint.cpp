@@ -0,0 +1,126 @@
+// These are classes that fingerprint depends on
+#include "../../../autotools.hh"
+#include <casmutils/definitions.hpp>
+#include <casmutils/exceptions.hpp>
+#include <casmutils/xtal/lattice.hpp>
+#include <casmutils/xtal/site.hpp>
+#include <casmutils/xtal/structure.hpp>
+#include <casmutils/xtal/structure_tools.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+// This file tests the functions in:
+#include <casmutils/xtal/fingerprint.hpp>
+
+namespace cu = casmutils;
+
+class FingerprintTest : public testing::Test
+{
+protected:
+    using Structure = cu::xtal::Structure;
+    void SetUp() override
+    {
+        fcc_Ni_ptr = std::make_unique<Structure>(
+            Structure::from_poscar(cu::autotools::input_filesdir / "primitive_fcc_Ni.vasp"));
+        bcc_Ni_ptr = std::make_unique<Structure>(
+            Structure::from_poscar(cu::autotools::input_filesdir / "primitive_bcc_Ni.vasp"));
+
+        cu::xtal::Lattice rocksalt_lat(
+            Eigen::Vector3d(0, 2.1, 2.1), Eigen::Vector3d(2.1, 0, 2.1), Eigen::Vector3d(2.1, 2.1, 0));
+        rocksalt_ptr = std::make_unique<Structure>(
+            rocksalt_lat,
+            std::vector<cu::xtal::Site>{cu::xtal::Site(Eigen::Vector3d(0, 0, 0), "Ni"),
+                                        cu::xtal::Site(Eigen::Vector3d(2.1, 2.1, 2.1), "O")});
+    }
+
+    /// Rotates the whole structure about the z axis and moves it off the origin
+    Structure rotate_and_translate(const Structure& struc)
+    {
+        Eigen::Matrix3d rotation = Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+        Eigen::Vector3d translation(0.31, -0.17, 0.55);
+        cu::xtal::Lattice rotated_lat(rotation * struc.lattice().column_vector_matrix());
+        Eigen::Matrix3Xd moved_coords = (rotation * struc.cart_coords()).colwise() + translation;
+        return Structure(rotated_lat, moved_coords, struc.species_ids());
+    }
+
+    double tol = 1e-5;
+    std::unique_ptr<Structure> fcc_Ni_ptr;
+    std::unique_ptr<Structure> bcc_Ni_ptr;
+    std::unique_ptr<Structure> rocksalt_ptr;
+};
+
+TEST_F(FingerprintTest, InvariantUnderRotationAndTranslation)
+{
+    for (const Structure* struc : {fcc_Ni_ptr.get(), rocksalt_ptr.get()})
+    {
+        auto original = cu::xtal::fingerprint(*struc, tol);
+        auto moved = cu::xtal::fingerprint(rotate_and_translate(*struc), tol);
+        EXPECT_TRUE(cu::xtal::could_be_equivalent(original, moved));
+        EXPECT_EQ(original.hash(), moved.hash());
+    }
+}
+
+TEST_F(FingerprintTest, InvariantUnderSupercellAndPermutation)
+{
+    Eigen::Matrix3i transformation;
+    transformation << 1, 1, 0, -1, 1, 0, 0, 1, 2;
+    Structure super_rocksalt = cu::xtal::make_superstructure(*rocksalt_ptr, transformation);
+    ASSERT_EQ(super_rocksalt.species_ids().size(), 8);
+
+    // Reverse the order of the basis
+    Eigen::Matrix3Xd reversed_coords = super_rocksalt.cart_coords().rowwise().reverse();
+    std::vector<int> reversed_species(super_rocksalt.species_ids().rbegin(), super_rocksalt.species_ids().rend());
+    Structure reversed_super_rocksalt(super_rocksalt.lattice(), reversed_coords, reversed_species);
+
+    auto original = cu::xtal::fingerprint(*rocksalt_ptr, tol);
+    for (const Structure& struc : {super_rocksalt, reversed_super_rocksalt})
+    {
+        auto super = cu::xtal::fingerprint(struc, tol);
+        EXPECT_TRUE(cu::xtal::could_be_equivalent(original, super));
+        EXPECT_EQ(original.hash(), super.hash());
+    }
+}
+
+TEST_F(FingerprintTest, SmallDisplacementsMightBeEquivalent)
+{
+    Structure nudged_rocksalt = *rocksalt_ptr;
+    nudged_rocksalt.set_cart(1, nudged_rocksalt.cart_coords().col(1) + Eigen::Vector3d(0.3, 0.2, 0.1) * tol);
+    EXPECT_TRUE(cu::xtal::could_be_equivalent(cu::xtal::fingerprint(*rocksalt_ptr, tol),
+                                              cu::xtal::fingerprint(nudged_rocksalt, tol)));
+
+    Structure displaced_rocksalt = *rocksalt_ptr;
+    displaced_rocksalt.set_cart(1, displaced_rocksalt.cart_coords().col(1) + Eigen::Vector3d(0.3, 0.2, 0.1));
+    EXPECT_FALSE(cu::xtal::could_be_equivalent(cu::xtal::fingerprint(*rocksalt_ptr, tol),
+                                               cu::xtal::fingerprint(displaced_rocksalt, tol)));
+}
+
+TEST_F(FingerprintTest, DifferentStructuresAreToldApart)
+{
+    auto fcc = cu::xtal::fingerprint(*fcc_Ni_ptr, tol);
+    auto bcc = cu::xtal::fingerprint(*bcc_Ni_ptr, tol);
+    auto rocksalt = cu::xtal::fingerprint(*rocksalt_ptr, tol);
+
+    EXPECT_FALSE(cu::xtal::could_be_equivalent(fcc, bcc));
+    EXPECT_FALSE(cu::xtal::could_be_equivalent(fcc, rocksalt));
+    EXPECT_NE(fcc.hash(), bcc.hash());
+    EXPECT_NE(fcc.composition_hash, rocksalt.composition_hash);
+    EXPECT_EQ(fcc.composition_hash, bcc.composition_hash);
+
+    // Same volume per atom and composition, but a different arrangement
+    double fcc_scale = std::cbrt(bcc.volume_per_atom / fcc.volume_per_atom);
+    cu::xtal::Lattice scaled_fcc_lat(fcc_scale * fcc_Ni_ptr->lattice().column_vector_matrix());
+    Structure scaled_fcc(scaled_fcc_lat, fcc_scale * fcc_Ni_ptr->cart_coords(), fcc_Ni_ptr->species_ids());
+    EXPECT_FALSE(cu::xtal::could_be_equivalent(cu::xtal::fingerprint(scaled_fcc, tol), bcc));
+}
+
+TEST_F(FingerprintTest, EmptyStructure)
+{
+    Structure empty(fcc_Ni_ptr->lattice(), std::vector<cu::xtal::Site>{});
+    EXPECT_THROW(cu::xtal::fingerprint(empty, tol), except::UserInputMangle);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
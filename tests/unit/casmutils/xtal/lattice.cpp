@@ -148,6 +148,38 @@ TEST_F(LatticeTest, ConstMakeNiggli)
     EXPECT_TRUE(casmutils::is_equal<casmutils::xtal::LatticeEquals_f>(*conventional_fcc_ptr, niggli, tol));
 }
 
+TEST_F(LatticeTest, DerivedQuantities)
+{
+    // inverse, metric, volume and reciprocal should agree with computing them by hand
+    const Eigen::Matrix3d& fcc_matrix = fcc_ptr->column_vector_matrix();
+    Eigen::Matrix3d expected_inverse = fcc_matrix.inverse();
+    Eigen::Matrix3d expected_metric = fcc_matrix.transpose() * fcc_matrix;
+    EXPECT_TRUE(casmutils::almost_equal(fcc_ptr->inverse_column_vector_matrix(), expected_inverse, tol));
+    EXPECT_TRUE(casmutils::almost_equal(fcc_ptr->metric(), expected_metric, tol));
+    EXPECT_TRUE(casmutils::almost_equal(fcc_ptr->volume(), fcc_matrix.determinant(), tol));
+
+    Lattice reciprocal = casmutils::xtal::make_reciprocal(*fcc_ptr);
+    Eigen::Matrix3d expected_reciprocal = 2 * M_PI * fcc_matrix.inverse().transpose();
+    EXPECT_TRUE(casmutils::almost_equal(reciprocal.column_vector_matrix(), expected_reciprocal, tol));
+    EXPECT_TRUE(casmutils::almost_equal(reciprocal.column_vector_matrix().transpose() * fcc_matrix,
+                                        Eigen::Matrix3d(2 * M_PI * Eigen::Matrix3d::Identity()),
+                                        tol));
+}
+
+TEST_F(LatticeTest, CASMRepresentation)
+{
+    // the CASM lattice is built on demand, and should have the same vectors
+    EXPECT_TRUE(casmutils::almost_equal(fcc_ptr->__get().lat_column_mat(), fcc_ptr->column_vector_matrix(), tol));
+
+    // copies and reassignments don't hold on to stale representations
+    Lattice copied_lattice = *fcc_ptr;
+    copied_lattice = *bcc_ptr;
+    const Eigen::Matrix3d& bcc_matrix = bcc_ptr->column_vector_matrix();
+    Eigen::Matrix3d bcc_inverse = bcc_matrix.inverse();
+    EXPECT_TRUE(casmutils::almost_equal(copied_lattice.__get().lat_column_mat(), bcc_matrix, tol));
+    EXPECT_TRUE(casmutils::almost_equal(copied_lattice.inverse_column_vector_matrix(), bcc_inverse, tol));
+}
+
 class LatticeIsEquivalentTest : public testing::Test
 {
 protected:
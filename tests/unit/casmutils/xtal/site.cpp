@@ -2,11 +2,35 @@
 #include <casmutils/misc.hpp>
 #include <casmutils/xtal/coordinate.hpp>
 #include <casmutils/xtal/lattice.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <gtest/gtest.h>
 #include <memory>
+#include <new>
 // tests the functions in this file
 #include <casmutils/xtal/site.hpp>
 
+// Every allocation in this test program goes through here, so tests can check that hot loops don't allocate
+namespace
+{
+std::atomic<long> allocation_count(0);
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocation_count;
+    if (void* allocated = std::malloc(size == 0 ? 1 : size))
+    {
+        return allocated;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* allocated) noexcept { std::free(allocated); }
+
+void operator delete(void* allocated, std::size_t) noexcept { std::free(allocated); }
+
 class SiteTest : public testing::Test
 {
 protected:
@@ -40,6 +64,18 @@ TEST_F(SiteTest, Construct)
     EXPECT_EQ(nickel_site_ptr->label(), "Ni");
 }
 
+TEST_F(SiteTest, SpeciesId)
+{
+    // sites with the same label share the same species id
+    Site other_lithium_site(Eigen::Vector3d::Zero(), "Li");
+    EXPECT_EQ(lithium_site_ptr->species(), other_lithium_site.species());
+    EXPECT_NE(lithium_site_ptr->species(), nickel_site_ptr->species());
+
+    // constructing from the id is the same as constructing from the name
+    Site lithium_from_id(lithium_site_ptr->cart(), lithium_site_ptr->species());
+    EXPECT_EQ(lithium_from_id.label(), "Li");
+}
+
 TEST_F(SiteTest, FracConversion)
 {
     // checks the ability to get the fractional
@@ -64,6 +100,39 @@ TEST_F(SiteTest, SiteEquals)
     EXPECT_FALSE(unary_site_comparator(*nickel_site_ptr));
 };
 
+TEST_F(SiteTest, ComparisonsDontAllocate)
+{
+    // Micro-benchmark of the loops that compare and copy sites, which used to copy a name per site
+    const int n_sites = 2000;
+    std::vector<Site> sites;
+    sites.reserve(n_sites);
+    for (int i = 0; i < n_sites; ++i)
+    {
+        sites.emplace_back(Eigen::Vector3d(0.1 * i, 0, 0), i % 2 ? "Li" : "Ni");
+    }
+    std::vector<Site> copied_sites(sites);
+    std::vector<Site> reversed_sites(sites.rbegin(), sites.rend());
+    casmutils::xtal::SiteEquals_f site_equals(1e-5);
+
+    long allocations_before = allocation_count;
+    auto start = std::chrono::steady_clock::now();
+    int n_equal = 0;
+    std::size_t label_lengths = 0;
+    for (int i = 0; i < n_sites; ++i)
+    {
+        n_equal += site_equals(sites[i], copied_sites[i]);
+        n_equal += site_equals(sites[i], reversed_sites[i]);
+        label_lengths += sites[i].label().size();
+        copied_sites[i] = reversed_sites[i];
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(allocation_count - allocations_before, 0);
+    EXPECT_EQ(n_equal, n_sites);
+    EXPECT_EQ(label_lengths, 2 * n_sites);
+    RecordProperty("nanoseconds_per_site", std::to_string(seconds * 1e9 / n_sites));
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
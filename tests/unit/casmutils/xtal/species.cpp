@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+// tests the functions in this file
+#include <casmutils/xtal/species.hpp>
+
+TEST(SpeciesTest, IdsAreStable)
+{
+    // the same name always maps to the same id, and different names to different ids
+    int li_id = casmutils::xtal::species_id("Li");
+    int ni_id = casmutils::xtal::species_id("Ni");
+    EXPECT_NE(li_id, ni_id);
+    EXPECT_EQ(li_id, casmutils::xtal::species_id("Li"));
+    EXPECT_EQ(ni_id, casmutils::xtal::species_id(std::string("Ni")));
+}
+
+TEST(SpeciesTest, NameRoundTrip)
+{
+    // names come back unchanged, and always as the same object
+    int o_id = casmutils::xtal::species_id("O");
+    EXPECT_EQ(casmutils::xtal::species_name(o_id), "O");
+    EXPECT_EQ(&casmutils::xtal::species_name(o_id), &casmutils::xtal::species_name(o_id));
+    EXPECT_GT(casmutils::xtal::species_count(), o_id);
+}
+
+TEST(SpeciesTest, ReferencesSurviveRegistration)
+{
+    // registering plenty of new names must not move the ones handed out earlier
+    int mg_id = casmutils::xtal::species_id("Mg");
+    const std::string* mg_name = &casmutils::xtal::species_name(mg_id);
+    for (int i = 0; i < 1000; ++i)
+    {
+        casmutils::xtal::species_id("Dummy" + std::to_string(i));
+    }
+    EXPECT_EQ(mg_name, &casmutils::xtal::species_name(mg_id));
+    EXPECT_EQ(*mg_name, "Mg");
+}
+
+TEST(SpeciesTest, ConcurrentRegistration)
+{
+    // every thread registers the same names, they should all agree on the ids
+    int n_threads = 8;
+    int n_names = 200;
+    std::vector<std::vector<int>> thread_ids(n_threads, std::vector<int>(n_names));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t)
+    {
+        threads.emplace_back([t, n_names, &thread_ids]() {
+            for (int i = 0; i < n_names; ++i)
+            {
+                thread_ids[t][i] = casmutils::xtal::species_id("Concurrent" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (int t = 1; t < n_threads; ++t)
+    {
+        EXPECT_EQ(thread_ids[0], thread_ids[t]);
+    }
+    for (int i = 0; i < n_names; ++i)
+    {
+        EXPECT_EQ(casmutils::xtal::species_name(thread_ids[0][i]), "Concurrent" + std::to_string(i));
+    }
+}
+
+TEST(SpeciesTest, UnregisteredIds)
+{
+    EXPECT_THROW(casmutils::xtal::species_name(-1), std::out_of_range);
+    EXPECT_THROW(casmutils::xtal::species_name(casmutils::xtal::species_count()), std::out_of_range);
+}
+
+TEST(SpeciesTest, ReadWhileRegistering)
+{
+    // names registered earlier can be read while other threads keep registering new ones
+    int fe_id = casmutils::xtal::species_id("Fe");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < 500; ++i)
+            {
+                casmutils::xtal::species_id("Reader" + std::to_string(t) + "_" + std::to_string(i));
+            }
+        });
+    }
+    for (int i = 0; i < 10000; ++i)
+    {
+        ASSERT_EQ(casmutils::xtal::species_name(fe_id), "Fe");
+        int newest_id = casmutils::xtal::species_count() - 1;
+        ASSERT_FALSE(casmutils::xtal::species_name(newest_id).empty());
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,11 +1,16 @@
 // These are classes that structure depends on
 #include "../../../autotools.hh"
+#include <casm/crystallography/BasicStructure.hh>
+#include <casm/crystallography/SimpleStructure.hh>
 #include <casmutils/definitions.hpp>
+#include <casmutils/exceptions.hpp>
 #include <casmutils/misc.hpp>
 #include <casmutils/xtal/coordinate.hpp>
 #include <casmutils/xtal/lattice.hpp>
 #include <casmutils/xtal/site.hpp>
+#include <casmutils/xtal/species.hpp>
 #include <gtest/gtest.h>
+#include <sstream>
 // This file tests the functions in:
 #include <casmutils/xtal/structure.hpp>
 
@@ -66,6 +71,60 @@ TEST_F(StructureTest, ReadfromPOSCAR)
     EXPECT_TRUE(casmutils::is_equal<casmutils::xtal::LatticeEquals_f>(*cubic_lat_ptr, pos.lattice(), tol));
     EXPECT_TRUE(casmutils::is_equal<casmutils::xtal::SiteEquals_f>((*basis0_ptr)[0], pos.basis_sites()[0], tol));
 }
+TEST_F(StructureTest, ReadPOSCARFormats)
+{
+    namespace cu = casmutils;
+    // The same structure written in VASP 5 with Selective Dynamics and Direct coordinates,
+    // and in VASP 4 with Cartesian coordinates and a volume scaling factor
+    std::string vasp5_text = "NiO\n"
+                             " 2.0\n"
+                             " 1 0 0\n"
+                             " 0 1 0\n"
+                             " 0 0 1.5\n"
+                             " Ni O\n"
+                             " 1 2\n"
+                             "Selective dynamics\n"
+                             "Direct\n"
+                             " 0 0 0 T T F\n"
+                             " 0.5 0.5 0.5 T T T\n"
+                             " +0.25 0.5 1.0e-1 F F F\n";
+    std::string vasp4_text = "NiO\r\n"
+                             "-12\r\n"
+                             " 1 0 0\r\n"
+                             " 0 1 0\r\n"
+                             " 0 0 1.5\r\n"
+                             " 1 2\r\n"
+                             "cartesian\r\n"
+                             " 0 0 0 Ni\r\n"
+                             " 0.5 0.5 0.75 O\r\n"
+                             " 0.25 0.5 0.15 O\r\n";
+
+    cu::xtal::Lattice expected_lat(Eigen::Vector3d(2, 0, 0), Eigen::Vector3d(0, 2, 0), Eigen::Vector3d(0, 0, 3));
+    std::vector<cu::xtal::Site> expected_basis{cu::xtal::Site(Eigen::Vector3d(0, 0, 0), "Ni"),
+                                               cu::xtal::Site(Eigen::Vector3d(1, 1, 1.5), "O"),
+                                               cu::xtal::Site(Eigen::Vector3d(0.5, 1, 0.3), "O")};
+
+    std::istringstream vasp5_stream(vasp5_text);
+    for (const cu::xtal::Structure& read_struc :
+         {cu::xtal::Structure::from_poscar_stream(vasp5_stream), cu::xtal::Structure::from_poscar_string(vasp4_text)})
+    {
+        EXPECT_TRUE(cu::is_equal<cu::xtal::LatticeEquals_f>(expected_lat, read_struc.lattice(), tol));
+        ASSERT_EQ(read_struc.basis_sites().size(), expected_basis.size());
+        for (int i = 0; i < expected_basis.size(); ++i)
+        {
+            EXPECT_TRUE(cu::is_equal<cu::xtal::SiteEquals_f>(expected_basis[i], read_struc.basis_sites()[i], tol));
+        }
+    }
+
+    EXPECT_THROW(cu::xtal::Structure::from_poscar_string("NiO\n1.0\n1 0 0\n0 1 0\n"), except::BadPOSCAR);
+    EXPECT_THROW(cu::xtal::Structure::from_poscar_string("NiO\n1.0\n1 0 0\n0 1 0\n0 0 1\nNi\n1\nDirect\n0 0 x\n"),
+                 except::BadPOSCAR);
+
+    // The directory exists, but there's nothing to read from it
+    EXPECT_THROW(cu::xtal::Structure::from_poscar(cu::autotools::input_filesdir), except::BadPath);
+    EXPECT_THROW(cu::xtal::Structure::from_poscar(cu::autotools::input_filesdir / "not_a_file.vasp"), except::BadPath);
+}
+
 TEST_F(StructureTest, SetLatticeFrac)
 {
     // FRACTIONAL CALL SHOULD CHANGE BASIS
@@ -106,6 +165,180 @@ TEST_F(StructureTest, Within)
     EXPECT_TRUE(
         casmutils::is_equal<casmutils::xtal::SiteEquals_f>((*basis0_ptr)[0], outside_structure.basis_sites()[0], tol));
 }
+TEST_F(StructureTest, CasmRepresentationsFollowChanges)
+{
+    // The CASM representations are only built when requested, make sure they
+    // reflect modifications made after they were first requested, and that
+    // copies don't see modifications made to the original
+    namespace cu = casmutils;
+    const Eigen::Matrix3d& small_mat = cubic_lat_ptr->column_vector_matrix();
+    const Eigen::Matrix3d& big_mat = big_cubic_lat_ptr->column_vector_matrix();
+
+    const auto& basic_before = cubic_Ni_struc_ptr->__get<CASM::xtal::BasicStructure>();
+    EXPECT_TRUE(cu::almost_equal(basic_before.lattice().lat_column_mat(), small_mat, tol));
+    cu::xtal::Structure copied_struc = *cubic_Ni_struc_ptr;
+
+    cubic_Ni_struc_ptr->set_lattice(*big_cubic_lat_ptr, cu::xtal::FRAC);
+
+    const auto& basic_after = cubic_Ni_struc_ptr->__get<CASM::xtal::BasicStructure>();
+    EXPECT_TRUE(cu::almost_equal(basic_after.lattice().lat_column_mat(), big_mat, tol));
+    EXPECT_TRUE(cu::almost_equal(basic_after.basis()[0].cart(), (*basis1_ptr)[0].cart(), tol));
+
+    const auto& simple_after = cubic_Ni_struc_ptr->__get<CASM::xtal::SimpleStructure>();
+    Eigen::Vector3d simple_coord = simple_after.atom_info.cart_coord(0);
+    EXPECT_TRUE(cu::almost_equal(simple_after.lat_column_mat, big_mat, tol));
+    EXPECT_TRUE(cu::almost_equal(simple_coord, (*basis1_ptr)[0].cart(), tol));
+
+    const auto& copied_basic = copied_struc.__get<CASM::xtal::BasicStructure>();
+    EXPECT_TRUE(cu::almost_equal(copied_basic.lattice().lat_column_mat(), small_mat, tol));
+    EXPECT_TRUE(cu::almost_equal(copied_basic.basis()[0].cart(), (*basis0_ptr)[0].cart(), tol));
+}
+
+TEST_F(StructureTest, ContiguousBasisAccess)
+{
+    // the coordinate block and species ids should match the basis sites
+    const Eigen::Matrix3Xd& coords = cubic_Ni_struc_ptr->cart_coords();
+    const std::vector<int>& species = cubic_Ni_struc_ptr->species_ids();
+    ASSERT_EQ(coords.cols(), 1);
+    ASSERT_EQ(species.size(), 1);
+    EXPECT_TRUE(casmutils::almost_equal(Eigen::Vector3d(coords.col(0)), (*basis0_ptr)[0].cart(), tol));
+    EXPECT_EQ(casmutils::xtal::species_name(species[0]), "Ni");
+
+    // constructing from the contiguous representation gives the same structure
+    casmutils::xtal::Structure block_struc(*cubic_lat_ptr, coords, species);
+    EXPECT_TRUE(casmutils::is_equal<casmutils::xtal::SiteEquals_f>(
+        (*basis0_ptr)[0], block_struc.basis_sites()[0], tol));
+
+    // mismatched number of coordinates and species
+    EXPECT_THROW(casmutils::xtal::Structure(*cubic_lat_ptr, Eigen::Matrix3Xd::Zero(3, 2), species),
+                 std::invalid_argument);
+    // species ids that were never registered
+    EXPECT_THROW(casmutils::xtal::Structure(*cubic_lat_ptr, coords, {casmutils::xtal::species_count()}),
+                 std::invalid_argument);
+    EXPECT_THROW(casmutils::xtal::Structure(*cubic_lat_ptr, coords, {-1}), std::invalid_argument);
+}
+
+TEST_F(StructureTest, BasisSitesFollowChanges)
+{
+    // the Site view of the basis has to be rebuilt after the coordinates move
+    const std::vector<casmutils::xtal::Site>& sites_before = cubic_Ni_struc_ptr->basis_sites();
+    EXPECT_TRUE(casmutils::is_equal<casmutils::xtal::SiteEquals_f>((*basis0_ptr)[0], sites_before[0], tol));
+
+    cubic_Ni_struc_ptr->set_lattice(*big_cubic_lat_ptr, casmutils::xtal::FRAC);
+    EXPECT_TRUE(casmutils::almost_equal(Eigen::Vector3d(cubic_Ni_struc_ptr->cart_coords().col(0)),
+                                        (*basis1_ptr)[0].cart(),
+                                        tol));
+    EXPECT_TRUE(casmutils::is_equal<casmutils::xtal::SiteEquals_f>(
+        (*basis1_ptr)[0], cubic_Ni_struc_ptr->basis_sites()[0], tol));
+}
+
+TEST_F(StructureTest, EditBasisInPlace)
+{
+    namespace cu = casmutils;
+    cu::xtal::Structure edited_struc = *cubic_Ni_struc_ptr;
+    // build every representation, so that the edits have to keep them up to date
+    edited_struc.basis_sites();
+    edited_struc.__get<CASM::xtal::BasicStructure>();
+    edited_struc.__get<CASM::xtal::SimpleStructure>();
+
+    edited_struc.add_site(cu::xtal::Site(Eigen::Vector3d(1, 1, 1), "O"));
+    edited_struc.add_site(cu::xtal::Site(Eigen::Vector3d(1, 0, 0), "Li"));
+    edited_struc.set_species(0, "Mg");
+    edited_struc.set_cart(1, Eigen::Vector3d(0.5, 0.5, 0.5));
+    edited_struc.remove_sites({2});
+
+    std::vector<cu::xtal::Site> expected_basis{cu::xtal::Site(Eigen::Vector3d(0, 0, 1), "Mg"),
+                                               cu::xtal::Site(Eigen::Vector3d(0.5, 0.5, 0.5), "O")};
+
+    const auto& edited_basis = edited_struc.basis_sites();
+    const auto& edited_basic = edited_struc.__get<CASM::xtal::BasicStructure>();
+    const auto& edited_simple = edited_struc.__get<CASM::xtal::SimpleStructure>();
+    ASSERT_EQ(edited_basis.size(), expected_basis.size());
+    ASSERT_EQ(edited_basic.basis().size(), expected_basis.size());
+    ASSERT_EQ(edited_simple.atom_info.names.size(), expected_basis.size());
+    for (int i = 0; i < expected_basis.size(); ++i)
+    {
+        const Eigen::Vector3d& expected_coord = expected_basis[i].cart();
+        EXPECT_TRUE(cu::is_equal<cu::xtal::SiteEquals_f>(expected_basis[i], edited_basis[i], tol));
+        EXPECT_TRUE(cu::almost_equal(Eigen::Vector3d(edited_struc.cart_coords().col(i)), expected_coord, tol));
+        EXPECT_TRUE(cu::almost_equal(edited_basic.basis()[i].cart(), expected_coord, tol));
+        EXPECT_EQ(edited_basic.basis()[i].allowed_occupants()[0], expected_basis[i].label());
+        EXPECT_EQ(edited_simple.atom_info.names[i], expected_basis[i].label());
+    }
+
+    // the structure we copied from is untouched
+    ASSERT_EQ(cubic_Ni_struc_ptr->basis_sites().size(), 1);
+    EXPECT_TRUE(
+        cu::is_equal<cu::xtal::SiteEquals_f>((*basis0_ptr)[0], cubic_Ni_struc_ptr->basis_sites()[0], tol));
+    EXPECT_EQ(cubic_Ni_struc_ptr->__get<CASM::xtal::BasicStructure>().basis().size(), 1);
+
+    EXPECT_THROW(edited_struc.set_species(2, "Ni"), std::out_of_range);
+    EXPECT_THROW(edited_struc.remove_sites({-1}), std::out_of_range);
+}
+
+TEST_F(StructureTest, LatticeOnlyCopiesShareBasis)
+{
+    namespace cu = casmutils;
+    cu::xtal::Lattice stretched_lat(Eigen::Vector3d(2, 0, 0), Eigen::Vector3d(0, 1, 0), Eigen::Vector3d(0, 0, 1));
+    const cu::xtal::Structure& cubic_Ni_strucref = *cubic_Ni_struc_ptr;
+    cu::xtal::Structure stretched_struc = cubic_Ni_strucref.set_lattice(stretched_lat, cu::xtal::CART);
+
+    // Only the lattice changed, so the basis isn't duplicated
+    EXPECT_EQ(&stretched_struc.cart_coords(), &cubic_Ni_strucref.cart_coords());
+    EXPECT_EQ(&stretched_struc.species_ids(), &cubic_Ni_strucref.species_ids());
+    EXPECT_EQ(&stretched_struc.basis_sites(), &cubic_Ni_strucref.basis_sites());
+
+    // Editing the copy gives it its own basis and leaves the original alone
+    stretched_struc.set_cart(0, Eigen::Vector3d(0.5, 0.5, 0.5));
+    stretched_struc.set_species(0, "Mg");
+    EXPECT_NE(&stretched_struc.cart_coords(), &cubic_Ni_strucref.cart_coords());
+    EXPECT_EQ(stretched_struc.basis_sites()[0].label(), "Mg");
+    EXPECT_TRUE(cu::is_equal<cu::xtal::SiteEquals_f>((*basis0_ptr)[0], cubic_Ni_strucref.basis_sites()[0], tol));
+
+    // Keeping fractional coordinates moves the sites, which can't be shared
+    cu::xtal::Structure frac_struc = cubic_Ni_strucref.set_lattice(stretched_lat, cu::xtal::FRAC);
+    EXPECT_NE(&frac_struc.cart_coords(), &cubic_Ni_strucref.cart_coords());
+    EXPECT_EQ(&frac_struc.species_ids(), &cubic_Ni_strucref.species_ids());
+}
+
+TEST_F(StructureTest, KeepsEveryAllowedOccupant)
+{
+    namespace cu = casmutils;
+    CASM::xtal::BasicStructure prim(cubic_lat_ptr->__get());
+    std::vector<CASM::xtal::Molecule> ni_or_vacancy{CASM::xtal::Molecule::make_atom("Ni"),
+                                                    CASM::xtal::Molecule::make_atom("Va")};
+    prim.set_basis().emplace_back(CASM::xtal::Coordinate(Eigen::Vector3d(0, 0, 0), prim.lattice(), CASM::CART),
+                                  ni_or_vacancy);
+    prim.set_basis().emplace_back(CASM::xtal::Coordinate(Eigen::Vector3d(1, 1, 1), prim.lattice(), CASM::CART),
+                                  "O");
+
+    cu::xtal::Structure prim_struc(prim);
+    EXPECT_EQ(prim_struc.basis_sites()[0].label(), "Ni");
+
+    // Every edit rebuilds the CASM representation, which must still allow the vacancy
+    prim_struc.set_lattice(*big_cubic_lat_ptr, cu::xtal::FRAC);
+    prim_struc.set_cart(0, Eigen::Vector3d(0.1, 0, 0));
+    prim_struc.add_site(cu::xtal::Site(Eigen::Vector3d(2, 2, 2), "Li"));
+    prim_struc.within();
+    std::vector<std::vector<std::string>> expected_occupants{{"Ni", "Va"}, {"O"}, {"Li"}};
+    const auto& edited_basis = prim_struc.__get<CASM::xtal::BasicStructure>().basis();
+    ASSERT_EQ(edited_basis.size(), expected_occupants.size());
+    for (int i = 0; i < expected_occupants.size(); ++i)
+    {
+        EXPECT_EQ(edited_basis[i].allowed_occupants(), expected_occupants[i]);
+    }
+
+    // Removing a site keeps the others lined up, and a new species replaces the alternatives
+    prim_struc.remove_sites({1});
+    EXPECT_EQ(prim_struc.__get<CASM::xtal::BasicStructure>().basis()[0].allowed_occupants(),
+              expected_occupants[0]);
+    prim_struc.set_species(0, "Mg");
+    EXPECT_EQ(prim_struc.__get<CASM::xtal::BasicStructure>().basis()[0].allowed_occupants(),
+              std::vector<std::string>{"Mg"});
+    EXPECT_EQ(prim_struc.__get<CASM::xtal::BasicStructure>().basis()[1].allowed_occupants(),
+              std::vector<std::string>{"Li"});
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
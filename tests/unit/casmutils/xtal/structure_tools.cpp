@@ -1,13 +1,18 @@
 // These are classes that structure_tools depends on
 #include "../../../autotools.hh"
+#include <casm/crystallography/SimpleStructure.hh>
+#include <casm/crystallography/io/VaspIO.hh>
 #include <casmutils/definitions.hpp>
+#include <casmutils/exceptions.hpp>
 #include <casmutils/misc.hpp>
 #include <casmutils/stage.hpp>
 #include <casmutils/xtal/coordinate.hpp>
 #include <casmutils/xtal/lattice.hpp>
 #include <casmutils/xtal/site.hpp>
 #include <casmutils/xtal/structure.hpp>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <sstream>
 // This file tests the functions in:
 #include <casmutils/xtal/structure_tools.hpp>
 
@@ -163,6 +168,131 @@ TEST_F(StructureToolsTest, WritePOSCAR)
     EXPECT_TRUE(cartesian_basis_is_equal(cubic_Ni_struc_ptr->basis_sites(), pos.basis_sites()));
 }
 
+TEST_F(StructureToolsTest, PrintPOSCARMatchesCASM)
+{
+    // The native writer has to produce exactly what CASM writes
+    auto casm_poscar = [](const Structure& printable) {
+        std::ostringstream casm_stream;
+        CASM::VaspIO::PrintPOSCAR p(printable.__get<CASM::xtal::SimpleStructure>());
+        p.sort();
+        p.print(casm_stream);
+        return casm_stream.str();
+    };
+
+    // Unsorted species, vacancies, and negative coordinates
+    casmutils::xtal::Lattice skewed_lat(
+        Eigen::Vector3d(3.1, 0.2, -0.1), Eigen::Vector3d(-1.5, 2.7, 0), Eigen::Vector3d(0.3, 0.1, 12.25));
+    Structure mixed_struc(skewed_lat,
+                          {casmutils::xtal::Site(Eigen::Vector3d(0.1, 0.2, 0.3), "O"),
+                           casmutils::xtal::Site(Eigen::Vector3d(-0.4, 1.1, 6.0), "Va"),
+                           casmutils::xtal::Site(Eigen::Vector3d(1.0, 1.0, -1.0), "Li"),
+                           casmutils::xtal::Site(Eigen::Vector3d(2.0, 0.5, 3.3), "O"),
+                           casmutils::xtal::Site(Eigen::Vector3d(0.0, 0.0, 0.0), "Co")});
+
+    // Values long enough in scientific notation to change how the columns get aligned
+    Structure tiny_struc(*cubic_Ni_struc_ptr);
+    tiny_struc.add_site(casmutils::xtal::Site(Eigen::Vector3d(2.4691358e-05, -1e-12, 1.0), "Ni"));
+
+    Structure vacancy_struc(skewed_lat, {casmutils::xtal::Site(Eigen::Vector3d(0, 0, 0), "Va")});
+
+    // More atoms than fit in a row of the species counts, with the species cycling through the basis
+    std::vector<casmutils::xtal::Site> interleaved_sites;
+    std::vector<std::string> cycled_species{"Zr", "O", "Ni", "O", "Al"};
+    for (int i = 0; i < 27; ++i)
+    {
+        Eigen::Vector3d coord(0.11 * i, 0.5 - 0.07 * i, 0.37 * (i % 4));
+        interleaved_sites.emplace_back(coord, cycled_species[i % cycled_species.size()]);
+    }
+    Structure interleaved_struc(skewed_lat, interleaved_sites);
+
+    for (const Structure* printable : {cubic_Ni_struc_ptr.get(),
+                                       conventional_fcc_Ni_ptr.get(),
+                                       deformed_conventional_fcc_Ni_ptr.get(),
+                                       &mixed_struc,
+                                       &tiny_struc,
+                                       &vacancy_struc,
+                                       &interleaved_struc})
+    {
+        std::ostringstream native_stream;
+        casmutils::xtal::print_poscar(*printable, native_stream);
+        EXPECT_EQ(native_stream.str(), casm_poscar(*printable));
+    }
+
+    // The file has to hold exactly the same bytes
+    casmutils::fs::path written_path = "interleaved_poscar.vasp";
+    casmutils::xtal::write_poscar(interleaved_struc, written_path);
+    std::ifstream written_file(written_path);
+    std::stringstream written_text;
+    written_text << written_file.rdbuf();
+    EXPECT_EQ(written_text.str(), casm_poscar(interleaved_struc));
+    casmutils::fs::remove(written_path);
+
+    EXPECT_THROW(casmutils::xtal::write_poscar(interleaved_struc, "no_such_directory/POSCAR"), except::BadPath);
+}
+
+TEST_F(StructureToolsTest, ReadStructures)
+{
+    namespace cu = casmutils;
+    std::vector<cu::fs::path> paths{cu::autotools::input_filesdir / "simple_cubic_Ni.vasp",
+                                    cu::autotools::input_filesdir / "conventional_fcc_Ni.vasp",
+                                    cu::autotools::input_filesdir / "not_a_file.vasp",
+                                    cu::autotools::input_filesdir / "primitive_fcc_Ni.vasp"};
+    std::vector<const Structure*> expected{
+        cubic_Ni_struc_ptr.get(), conventional_fcc_Ni_ptr.get(), nullptr, primitive_fcc_Ni_ptr.get()};
+
+    // The missing file doesn't stop the others from being read, and the order is kept
+    auto results = cu::xtal::read_structures(paths, 3);
+    ASSERT_EQ(results.size(), paths.size());
+    for (int i = 0; i < paths.size(); ++i)
+    {
+        EXPECT_EQ(results[i].path, paths[i]);
+        ASSERT_EQ(results[i].ok(), expected[i] != nullptr);
+        if (expected[i] == nullptr)
+        {
+            EXPECT_FALSE(results[i].error.empty());
+            continue;
+        }
+        const Structure& read_struc = *results[i].structure;
+        EXPECT_TRUE(cu::is_equal<cu::xtal::LatticeEquals_f>(expected[i]->lattice(), read_struc.lattice(), tol));
+        EXPECT_TRUE(cartesian_basis_is_equal(expected[i]->basis_sites(), read_struc.basis_sites()));
+    }
+
+    auto matched = cu::xtal::read_structures_matching((cu::autotools::input_filesdir / "*_fcc_Ni.vasp").string());
+    ASSERT_EQ(matched.size(), 6);
+    EXPECT_TRUE(std::is_sorted(matched.begin(), matched.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.path < rhs.path;
+    }));
+    for (const auto& result : matched)
+    {
+        EXPECT_TRUE(result.ok());
+    }
+}
+
+TEST_F(StructureToolsTest, ReadBatchFileInChunks)
+{
+    namespace cu = casmutils;
+    cu::fs::path batch_path = cu::autotools::output_filesdir / "chunked_batch.txt";
+    std::ofstream batch_file(batch_path);
+    batch_file << "first.vasp\n\n  second.vasp \t\r\nthird.vasp\n\n\nfourth.vasp\nfifth.vasp";
+    batch_file.close();
+
+    std::vector<cu::fs::path> all_paths = cu::xtal::read_batch_file(batch_path);
+    std::vector<cu::fs::path> expected{"first.vasp", "second.vasp", "third.vasp", "fourth.vasp", "fifth.vasp"};
+    EXPECT_EQ(all_paths, expected);
+
+    cu::xtal::BatchFileReader batch_reader(batch_path);
+    std::vector<cu::fs::path> chunked_paths;
+    for (std::vector<cu::fs::path> chunk = batch_reader.next(2); !chunk.empty(); chunk = batch_reader.next(2))
+    {
+        EXPECT_LE(chunk.size(), 2);
+        chunked_paths.insert(chunked_paths.end(), chunk.begin(), chunk.end());
+    }
+    EXPECT_EQ(chunked_paths, expected);
+    EXPECT_TRUE(batch_reader.next(2).empty());
+
+    EXPECT_THROW(cu::xtal::BatchFileReader(cu::autotools::input_filesdir / "not_a_file.txt"), except::BadPath);
+}
+
 TEST_F(StructureToolsTest, MakePrimitive)
 {
     // checks to see if conventional fcc gets reduced to a primitive fcc